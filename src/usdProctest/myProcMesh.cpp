@@ -120,6 +120,23 @@ UsdProcTestMyProcMesh::CreateLengthAttr(VtValue const &defaultValue, bool writeS
                        writeSparsely);
 }
 
+UsdAttribute
+UsdProcTestMyProcMesh::GetDivisionsAttr() const
+{
+    return GetPrim().GetAttribute(UsdProcTestTokens->divisions);
+}
+
+UsdAttribute
+UsdProcTestMyProcMesh::CreateDivisionsAttr(VtValue const &defaultValue, bool writeSparsely) const
+{
+    return UsdSchemaBase::_CreateAttr(UsdProcTestTokens->divisions,
+                       SdfValueTypeNames->Int,
+                       /* custom = */ false,
+                       SdfVariabilityVarying,
+                       defaultValue,
+                       writeSparsely);
+}
+
 namespace {
 static inline TfTokenVector
 _ConcatenateAttributeNames(const TfTokenVector& left,const TfTokenVector& right)
@@ -138,6 +155,7 @@ UsdProcTestMyProcMesh::GetSchemaAttributeNames(bool includeInherited)
 {
     static TfTokenVector localNames = {
         UsdProcTestTokens->length,
+        UsdProcTestTokens->divisions,
     };
     static TfTokenVector allNames =
         _ConcatenateAttributeNames(
@@ -160,3 +178,22 @@ PXR_NAMESPACE_CLOSE_SCOPE
 // 'PXR_NAMESPACE_OPEN_SCOPE', 'PXR_NAMESPACE_CLOSE_SCOPE'.
 // ===================================================================== //
 // --(BEGIN CUSTOM CODE)--
+
+#include "generator.h"
+
+#include <algorithm>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+UsdProctestCubeParams
+UsdProcTestMyProcMesh::GetCubeParams(UsdTimeCode time) const
+{
+    UsdProctestCubeParams params;
+    GetLengthAttr().Get(&params.sideLength, time);
+    GetDivisionsAttr().Get(&params.divisions, time);
+    params.divisions = std::max(1, std::min(params.divisions,
+                                            UsdProctestMaxCubeDivisions));
+    return params;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
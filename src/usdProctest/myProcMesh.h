@@ -45,6 +45,7 @@
 PXR_NAMESPACE_OPEN_SCOPE
 
 class SdfAssetPath;
+struct UsdProctestCubeParams;
 
 // -------------------------------------------------------------------------- //
 // MYPROCMESH                                                                 //
@@ -151,7 +152,9 @@ public:
     // --------------------------------------------------------------------- //
     // LENGTH 
     // --------------------------------------------------------------------- //
-    /// The length
+    /// Length of the cube side. Read from the Usd_Proctest_SideLength
+    /// metadata by the usdProctest file format. The fallback is the
+    /// default of UsdProctestCubeParams.
     ///
     /// | ||
     /// | -- | -- |
@@ -169,6 +172,30 @@ public:
     USDPROCTEST_API
     UsdAttribute CreateLengthAttr(VtValue const &defaultValue = VtValue(), bool writeSparsely=false) const;
 
+public:
+    // --------------------------------------------------------------------- //
+    // DIVISIONS 
+    // --------------------------------------------------------------------- //
+    /// Number of quads along each edge of a cube side. Read from the
+    /// Usd_Proctest_Divisions metadata by the usdProctest file format. The
+    /// fallback is the default of UsdProctestCubeParams.
+    ///
+    /// | ||
+    /// | -- | -- |
+    /// | Declaration | `int divisions = 1` |
+    /// | C++ Type | int |
+    /// | \ref Usd_Datatypes "Usd Type" | SdfValueTypeNames->Int |
+    USDPROCTEST_API
+    UsdAttribute GetDivisionsAttr() const;
+
+    /// See GetDivisionsAttr(), and also 
+    /// \ref Usd_Create_Or_Get_Property for when to use Get vs Create.
+    /// If specified, author \p defaultValue as the attribute's default,
+    /// sparsely (when it makes sense to do so) if \p writeSparsely is \c true -
+    /// the default for \p writeSparsely is \c false.
+    USDPROCTEST_API
+    UsdAttribute CreateDivisionsAttr(VtValue const &defaultValue = VtValue(), bool writeSparsely=false) const;
+
 public:
     // ===================================================================== //
     // Feel free to add custom code below this line, it will be preserved by 
@@ -180,6 +207,14 @@ public:
     //  - Close the include guard with #endif
     // ===================================================================== //
     // --(BEGIN CUSTOM CODE)--
+
+    /// Return the parameters of the cube described by the schema attributes
+    /// at \p time, the same parameters the usdProctest file format reads
+    /// from metadata. Unauthored attributes resolve to their fallbacks,
+    /// which are the defaults of UsdProctestCubeParams. Include
+    /// usdProctestCore/generator.h to use the returned parameters.
+    USDPROCTEST_API
+    UsdProctestCubeParams GetCubeParams(UsdTimeCode time=UsdTimeCode::Default()) const;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
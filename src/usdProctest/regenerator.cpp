@@ -0,0 +1,273 @@
+#include "pxr/usd/usdProcTest/regenerator.h"
+#include "pxr/usd/usdProcTest/myProcMesh.h"
+#include "pxr/usd/usdProcTest/tokens.h"
+
+#include "pxr/usd/usd/primRange.h"
+#include "pxr/usd/usdGeom/tokens.h"
+#include "pxr/usd/sdf/attributeSpec.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/sdf/types.h"
+
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/staticTokens.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/base/work/loops.h"
+
+#include "generator.h"
+
+#include <algorithm>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(
+    _tokens,
+    // Id of the usdProctest file format, which generates the geometry of the
+    // MyProcMesh prims it defines itself.
+    ((proctestFileFormatId, "usdProctestFileFormat"))
+);
+
+namespace {
+
+// Return true if \p prim is defined by a layer of the usdProctest file
+// format. Its geometry is then generated by the file format, possibly left
+// implicit or stored at a reduced precision, and must not be overridden.
+bool
+_IsGeneratedByFileFormat(const UsdPrim &prim)
+{
+    for (const SdfPrimSpecHandle &primSpec : prim.GetPrimStack()) {
+        const SdfFileFormatConstPtr fileFormat =
+            primSpec->GetLayer()->GetFileFormat();
+        if (fileFormat &&
+            fileFormat->GetFormatId() == _tokens->proctestFileFormatId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return true if \p name is the name of one of the attributes the
+// MyProcMesh schema generates its geometry from.
+bool
+_IsCubeParamAttr(const TfToken &name)
+{
+    const TfTokenVector &names =
+        UsdProcTestMyProcMesh::GetSchemaAttributeNames(false);
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// Geometry of a MyProcMesh, generated by the usdProctest file format
+// generator so that a MyProcMesh and a proctest payload with the same
+// parameters are identical.
+struct _CubeGeometry {
+    VtIntArray faceVertexCounts;
+    VtIntArray faceVertexIndices;
+    VtVec3fArray points;
+};
+
+// Author \p value as the default of the attribute \p name of \p primSpec,
+// creating the attribute spec if needed. Unchanged values are not
+// re-authored so that they do not contribute to the change notice.
+void
+_SetAttributeDefault(const SdfPrimSpecHandle &primSpec,
+                     const TfToken &name,
+                     const SdfValueTypeName &typeName,
+                     const VtValue &value)
+{
+    SdfAttributeSpecHandle attrSpec = primSpec->GetLayer()->GetAttributeAtPath(
+        primSpec->GetPath().AppendProperty(name));
+    if (!attrSpec) {
+        attrSpec = SdfAttributeSpec::New(primSpec, name, typeName);
+        if (!attrSpec) {
+            TF_RUNTIME_ERROR("Cannot create attribute <%s>",
+                             primSpec->GetPath().AppendProperty(name)
+                                 .GetText());
+            return;
+        }
+    }
+    if (attrSpec->GetDefaultValue() != value) {
+        attrSpec->SetDefaultValue(value);
+    }
+}
+
+} // anonymous namespace
+
+UsdProcTestMyProcMeshRegenerator::UsdProcTestMyProcMeshRegenerator(
+    const UsdStagePtr &stage, bool immediate)
+    : _stage(stage)
+    , _immediate(immediate)
+    , _isRegenerating(false)
+{
+    if (!_stage) {
+        TF_CODING_ERROR("Invalid stage");
+        return;
+    }
+    _objectsChangedKey = TfNotice::Register(
+        TfCreateWeakPtr(this),
+        &UsdProcTestMyProcMeshRegenerator::_OnObjectsChanged,
+        _stage);
+}
+
+UsdProcTestMyProcMeshRegenerator::~UsdProcTestMyProcMeshRegenerator()
+{
+    TfNotice::Revoke(_objectsChangedKey);
+}
+
+void
+UsdProcTestMyProcMeshRegenerator::RegenerateAll()
+{
+    if (!_stage) {
+        return;
+    }
+    _AddDirtySubtree(SdfPath::AbsoluteRootPath());
+    Flush();
+}
+
+void
+UsdProcTestMyProcMeshRegenerator::Flush()
+{
+    if (_dirtyPaths.empty()) {
+        return;
+    }
+    const SdfPathVector paths(_dirtyPaths.begin(), _dirtyPaths.end());
+    _dirtyPaths.clear();
+    Regenerate(paths);
+}
+
+void
+UsdProcTestMyProcMeshRegenerator::Regenerate(const SdfPathVector &paths)
+{
+    if (!_stage) {
+        TF_CODING_ERROR("Invalid stage");
+        return;
+    }
+
+    const SdfLayerHandle sessionLayer = _stage->GetSessionLayer();
+    if (!sessionLayer) {
+        TF_CODING_ERROR("Stage has no session layer to regenerate into");
+        return;
+    }
+
+    std::vector<UsdProcTestMyProcMesh> meshes;
+    meshes.reserve(paths.size());
+    for (const SdfPath &path : paths) {
+        UsdProcTestMyProcMesh mesh(_stage->GetPrimAtPath(path));
+        if (mesh && !_IsGeneratedByFileFormat(mesh.GetPrim())) {
+            meshes.push_back(mesh);
+        }
+    }
+    if (meshes.empty()) {
+        return;
+    }
+
+    // Reading the stage is thread safe, so parameters are fetched and
+    // geometry generated in parallel. Authoring is serial, in a single
+    // change block.
+
+    std::vector<_CubeGeometry> geometries(meshes.size());
+    WorkParallelForN(meshes.size(),
+        [&meshes, &geometries](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const UsdProctestCubeParams params = meshes[i].GetCubeParams();
+                const UsdProctestCubeRange range =
+                    UsdProctestGetCubeRange(params);
+                _CubeGeometry &geometry = geometries[i];
+                geometry.faceVertexCounts =
+                    UsdProctestGenerateCubeFaceVertexCounts(params, range);
+                geometry.faceVertexIndices =
+                    UsdProctestGenerateCubeFaceVertexIndices(params, range);
+                geometry.points = UsdProctestGenerateCubePoints(params);
+            }
+        });
+
+    _isRegenerating = true;
+    {
+        SdfChangeBlock changeBlock;
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            SdfPrimSpecHandle primSpec =
+                SdfCreatePrimInLayer(sessionLayer, meshes[i].GetPath());
+            if (!primSpec) {
+                TF_RUNTIME_ERROR("Cannot create prim spec <%s> in session "
+                                 "layer", meshes[i].GetPath().GetText());
+                continue;
+            }
+            _CubeGeometry &geometry = geometries[i];
+            _SetAttributeDefault(primSpec, UsdGeomTokens->faceVertexCounts,
+                                 SdfValueTypeNames->IntArray,
+                                 VtValue::Take(geometry.faceVertexCounts));
+            _SetAttributeDefault(primSpec, UsdGeomTokens->faceVertexIndices,
+                                 SdfValueTypeNames->IntArray,
+                                 VtValue::Take(geometry.faceVertexIndices));
+            _SetAttributeDefault(primSpec, UsdGeomTokens->points,
+                                 SdfValueTypeNames->Point3fArray,
+                                 VtValue::Take(geometry.points));
+        }
+    }
+    _isRegenerating = false;
+}
+
+void
+UsdProcTestMyProcMeshRegenerator::_AddDirtySubtree(const SdfPath &path)
+{
+    const UsdPrim root = _stage->GetPrimAtPath(path);
+    if (!root) {
+        return;
+    }
+    for (const UsdPrim &prim : UsdPrimRange(root)) {
+        if (prim.IsA<UsdProcTestMyProcMesh>()) {
+            _dirtyPaths.insert(prim.GetPath());
+        }
+    }
+}
+
+void
+UsdProcTestMyProcMeshRegenerator::_OnObjectsChanged(
+    const UsdNotice::ObjectsChanged &notice,
+    const UsdStageWeakPtr &sender)
+{
+    // Ignore the notices sent for our own session layer edits.
+    if (_isRegenerating || sender != _stage) {
+        return;
+    }
+
+    for (const SdfPath &path : notice.GetChangedInfoOnlyPaths()) {
+        if (path.IsPropertyPath() && _IsCubeParamAttr(path.GetNameToken())) {
+            _dirtyPaths.insert(path.GetPrimPath());
+        }
+    }
+
+    for (const SdfPath &path : notice.GetResyncedPaths()) {
+        if (path.IsPropertyPath()) {
+            if (_IsCubeParamAttr(path.GetNameToken())) {
+                _dirtyPaths.insert(path.GetPrimPath());
+            }
+        } else {
+            _AddDirtySubtree(path);
+        }
+    }
+
+    if (_immediate) {
+        Flush();
+    }
+}
+
+UsdProcTestMyProcMeshRegenerator::ChangeBlock::ChangeBlock(
+    UsdProcTestMyProcMeshRegenerator &regenerator)
+    : _regenerator(regenerator)
+    , _changeBlock(new SdfChangeBlock)
+{
+}
+
+UsdProcTestMyProcMeshRegenerator::ChangeBlock::~ChangeBlock()
+{
+    // Close the change block first, so that its notice marks the edited
+    // prims dirty before they are flushed.
+    _changeBlock.reset();
+    _regenerator.Flush();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
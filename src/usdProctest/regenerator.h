@@ -0,0 +1,116 @@
+#ifndef USDPROCTEST_REGENERATOR_H
+#define USDPROCTEST_REGENERATOR_H
+
+/// \file usdProcTest/regenerator.h
+
+#include "pxr/pxr.h"
+#include "pxr/usd/usdProcTest/api.h"
+#include "pxr/usd/usd/notice.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/path.h"
+
+#include "pxr/base/tf/notice.h"
+#include "pxr/base/tf/weakBase.h"
+
+#include <memory>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/// \class UsdProcTestMyProcMeshRegenerator
+///
+/// Opt-in stage service keeping the geometry of MyProcMesh prims in sync
+/// with their schema attributes, \c length and \c divisions.
+///
+/// The regenerator listens to UsdNotice::ObjectsChanged on its stage,
+/// collects the MyProcMesh prims whose schema attributes changed (or that
+/// were resynced) and writes their points and topology to the stage session
+/// layer. Prims defined by a proctest payload are skipped: the usdProctest
+/// file format already generates their geometry, which may be left
+/// implicit or stored at a reduced precision. All dirty prims of a flush
+/// are generated in parallel and authored inside a single SdfChangeBlock.
+///
+/// By default the regenerator coalesces: the notice handler only collects
+/// dirty prims, which are regenerated together, in a single change notice,
+/// by an explicit Flush() or when a ChangeBlock of the regenerator closes.
+/// Any number of unbatched edits then costs a single regeneration pass.
+///
+/// An immediate regenerator flushes on every ObjectsChanged notice instead,
+/// that is after every edit not wrapped in an SdfChangeBlock: setting
+/// \c length then \c divisions of a prim regenerates it twice, and editing
+/// N prims one by one regenerates N times, each time with its own change
+/// notice. It keeps the session layer up to date without explicit flushes,
+/// at the cost of bulk edits, which should then be made in change blocks.
+class UsdProcTestMyProcMeshRegenerator : public TfWeakBase
+{
+public:
+    USDPROCTEST_API
+    explicit UsdProcTestMyProcMeshRegenerator(const UsdStagePtr &stage,
+                                              bool immediate=false);
+
+    USDPROCTEST_API
+    ~UsdProcTestMyProcMeshRegenerator();
+
+    UsdProcTestMyProcMeshRegenerator(
+        const UsdProcTestMyProcMeshRegenerator &) = delete;
+    UsdProcTestMyProcMeshRegenerator &operator=(
+        const UsdProcTestMyProcMeshRegenerator &) = delete;
+
+    /// Regenerate every MyProcMesh prim on the stage.
+    USDPROCTEST_API
+    void RegenerateAll();
+
+    /// Regenerate the MyProcMesh prims at \p paths. Paths that do not
+    /// point to a MyProcMesh prim, or point to one defined by a proctest
+    /// payload, are ignored.
+    USDPROCTEST_API
+    void Regenerate(const SdfPathVector &paths);
+
+    /// Regenerate the prims collected since the last flush.
+    USDPROCTEST_API
+    void Flush();
+
+    /// Return the prims waiting for the next Flush().
+    const SdfPathSet &GetDirtyPaths() const {
+        return _dirtyPaths;
+    }
+
+    /// \class ChangeBlock
+    ///
+    /// SdfChangeBlock that flushes the regenerator when it closes, once the
+    /// change notice of the edits made in its scope has been sent. Nested
+    /// in another change block, the edits are only noticed when the
+    /// outermost block closes and wait for the next flush.
+    class ChangeBlock
+    {
+    public:
+        USDPROCTEST_API
+        explicit ChangeBlock(UsdProcTestMyProcMeshRegenerator &regenerator);
+
+        USDPROCTEST_API
+        ~ChangeBlock();
+
+        ChangeBlock(const ChangeBlock &) = delete;
+        ChangeBlock &operator=(const ChangeBlock &) = delete;
+
+    private:
+        UsdProcTestMyProcMeshRegenerator &_regenerator;
+        std::unique_ptr<SdfChangeBlock> _changeBlock;
+    };
+
+private:
+    void _OnObjectsChanged(const UsdNotice::ObjectsChanged &notice,
+                           const UsdStageWeakPtr &sender);
+
+    void _AddDirtySubtree(const SdfPath &path);
+
+    UsdStageWeakPtr _stage;
+    TfNotice::Key _objectsChangedKey;
+    SdfPathSet _dirtyPaths;
+    bool _immediate;
+    bool _isRegenerating;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
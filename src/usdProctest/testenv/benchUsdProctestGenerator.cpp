@@ -0,0 +1,85 @@
+// Benchmark of the cube generator: allocations and peak resident memory per
+// generated vertex. Every array is allocated once at its final size and
+// filled in place, so there is a single large allocation per output array
+// and the bytes allocated per vertex are those of the output.
+
+#include "testUtils.h"
+
+#include "pxr/pxr.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/stopwatch.h"
+#include "pxr/base/vt/array.h"
+
+#include "generator.h"
+
+#include <cstdio>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+int
+main()
+{
+    // Generate a first cube so that the allocations of the thread pool are
+    // not measured.
+    UsdProctestGenerateCubePoints(UsdProctestCubeParams());
+
+    printf("%10s %12s %12s %16s %16s %16s %10s\n", "divisions", "vertices",
+           "allocations", "allocs/vertex", "bytes/vertex", "peak rss/vertex",
+           "seconds");
+
+    for (const int divisions : {16, 64, 256, 1024}) {
+        UsdProctestCubeParams params;
+        params.divisions = divisions;
+        const UsdProctestCubeRange range = UsdProctestGetCubeRange(params);
+
+        // The smallest output array is the face vertex counts, one int per
+        // face.
+        UsdProctestSetLargeAllocationSize(
+            UsdProctestGetCubeFaceCount(params) * sizeof(int));
+
+        const bool hasPeakRss = UsdProctestResetPeakRss();
+        const size_t rss = UsdProctestGetRss();
+        const UsdProctestAllocations before = UsdProctestGetAllocations();
+        TfStopwatch stopwatch;
+        stopwatch.Start();
+
+        size_t outputBytes = 0;
+        {
+            const VtVec3fArray points =
+                UsdProctestGenerateCubePoints(params, range);
+            const VtIntArray faceVertexCounts =
+                UsdProctestGenerateCubeFaceVertexCounts(params, range);
+            const VtIntArray faceVertexIndices =
+                UsdProctestGenerateCubeFaceVertexIndices(params, range);
+            outputBytes = points.size() * sizeof(GfVec3f) +
+                          faceVertexCounts.size() * sizeof(int) +
+                          faceVertexIndices.size() * sizeof(int);
+        }
+
+        stopwatch.Stop();
+        const UsdProctestAllocations after = UsdProctestGetAllocations();
+        const size_t peakRss = UsdProctestGetPeakRss();
+
+        const double vertices =
+            static_cast<double>(UsdProctestGetCubePointCount(params));
+        const size_t allocationCount = after.count - before.count;
+        const size_t allocatedBytes = after.bytes - before.bytes;
+        printf("%10d %12.0f %12zu %16.3g %16.3g %16.3g %10.4f\n",
+               divisions, vertices, allocationCount,
+               allocationCount / vertices, allocatedBytes / vertices,
+               hasPeakRss && peakRss > rss ? (peakRss - rss) / vertices : 0.0,
+               stopwatch.GetSeconds());
+
+        // Each output array is allocated once, with no intermediate buffer
+        // nor growth, and thus no bytes beyond the arrays and their
+        // headers but those of scheduling.
+        if (UsdProctestHasAllocationCounts()) {
+            TF_AXIOM(after.largeCount - before.largeCount == 3);
+            TF_AXIOM(allocatedBytes >= outputBytes);
+            TF_AXIOM(allocatedBytes - outputBytes <= 64 * 1024);
+        }
+    }
+
+    return 0;
+}
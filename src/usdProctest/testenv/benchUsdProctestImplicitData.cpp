@@ -0,0 +1,107 @@
+// Benchmark of implicit face vertex indices against a plain VtIntArray
+// stored in the layer data: resident memory and read throughput, with and
+// without the cache of generated values.
+
+#include "testUtils.h"
+
+#include "pxr/pxr.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/stopwatch.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/base/vt/value.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/sdf/types.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "data.h"
+#include "generator.h"
+
+#include <cstdint>
+#include <cstdio>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static const size_t readCount = 20;
+
+static UsdProctestDataRefPtr
+_CreateData(const SdfPath &attrPath)
+{
+    UsdProctestDataRefPtr data = UsdProctestData::New();
+    data->CreateSpec(attrPath.GetPrimPath(), SdfSpecTypePrim);
+    data->CreateSpec(attrPath, SdfSpecTypeAttribute);
+    data->Set(attrPath, SdfFieldKeys->TypeName,
+              VtValue(SdfValueTypeNames->IntArray.GetAsToken()));
+    return data;
+}
+
+// Read the default of attrPath readCount times, summing the indices as a
+// consumer would walk them. Return the read throughput in bytes per second.
+static double
+_MeasureReads(const UsdProctestDataRefPtr &data, const SdfPath &attrPath)
+{
+    size_t bytes = 0;
+    int64_t sum = 0;
+    TfStopwatch stopwatch;
+    stopwatch.Start();
+    for (size_t i = 0; i < readCount; ++i) {
+        const VtValue value = data->Get(attrPath, SdfFieldKeys->Default);
+        const VtIntArray &indices = value.Get<VtIntArray>();
+        for (const int index : indices) {
+            sum += index;
+        }
+        bytes += indices.size() * sizeof(int);
+    }
+    stopwatch.Stop();
+    TF_AXIOM(sum > 0);
+    return bytes / stopwatch.GetSeconds();
+}
+
+int
+main()
+{
+    UsdProctestCubeParams params;
+    params.divisions = 512;
+    const UsdProctestCubeRange range = UsdProctestGetCubeRange(params);
+    const SdfPath attrPath =
+        SdfPath("/Cube").AppendProperty(UsdGeomTokens->faceVertexIndices);
+
+    UsdProctestDataRefPtr stored = _CreateData(attrPath);
+    stored->Set(attrPath, SdfFieldKeys->Default, VtValue::Take(
+        UsdProctestGenerateCubeFaceVertexIndices(params, range)));
+
+    UsdProctestDataRefPtr implicit = _CreateData(attrPath);
+    implicit->SetImplicitDefault(attrPath, [params, range]() {
+        return VtValue::Take(
+            UsdProctestGenerateCubeFaceVertexIndices(params, range));
+    });
+
+    const size_t storedBytes = stored->GetResidentBytes().topology;
+    const size_t implicitBytes = implicit->GetResidentBytes().topology;
+
+    const double storedThroughput = _MeasureReads(stored, attrPath);
+
+    UsdProctestData::SetImplicitCacheBudget(0);
+    const double uncachedThroughput = _MeasureReads(implicit, attrPath);
+    const size_t uncachedBytes = implicit->GetResidentBytes().topology;
+
+    UsdProctestData::SetImplicitCacheBudget(size_t(1) << 30);
+    const double cachedThroughput = _MeasureReads(implicit, attrPath);
+    const size_t cachedBytes = implicit->GetResidentBytes().topology;
+
+    printf("%-24s %16s %16s\n", "faceVertexIndices", "resident bytes",
+           "read MB/s");
+    printf("%-24s %16zu %16.0f\n", "VtIntArray", storedBytes,
+           storedThroughput / 1e6);
+    printf("%-24s %16zu %16.0f\n", "implicit, uncached", uncachedBytes,
+           uncachedThroughput / 1e6);
+    printf("%-24s %16zu %16.0f\n", "implicit, cached", cachedBytes,
+           cachedThroughput / 1e6);
+
+    // Implicit indices hold no array unless cached, in which case they hold
+    // a single one, as large as the stored array.
+    TF_AXIOM(implicitBytes == 0 && uncachedBytes == 0);
+    TF_AXIOM(cachedBytes == storedBytes);
+
+    return 0;
+}
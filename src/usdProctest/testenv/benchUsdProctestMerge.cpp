@@ -0,0 +1,141 @@
+// Benchmark of a layout of cubes merged into a single mesh by one proctest
+// payload, against the same layout with one proctest payload per cube:
+// prim count, generation time and memory.
+
+#include "testUtils.h"
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stopwatch.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/usd/sdf/payload.h"
+#include "pxr/usd/usd/payloads.h"
+#include "pxr/usd/usd/prim.h"
+#include "pxr/usd/usd/primRange.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/mesh.h"
+#include "pxr/usd/usdGeom/xformable.h"
+
+#include "data.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static const int cubeCount = 2000;
+static const int gridSize = 50;
+
+static float
+_GetSideLength(int cube)
+{
+    return 0.5f + 0.25f * static_cast<float>(cube % 3);
+}
+
+static GfVec3d
+_GetTranslation(int cube)
+{
+    return GfVec3d(cube % gridSize, cube / gridSize, 0.0);
+}
+
+struct _Measure {
+    size_t meshCount = 0;
+    double seconds = 0.0;
+    size_t rssBytes = 0;
+    size_t generatedBytes = 0;
+};
+
+static void
+_Print(const char *layout, const _Measure &measure)
+{
+    printf("%-20s %10zu %10.3f %16zu %16zu\n", layout, measure.meshCount,
+           measure.seconds, measure.rssBytes, measure.generatedBytes);
+}
+
+// Open the stage with open, then measure its meshes and the memory of the
+// generated content.
+template <class OpenFn>
+static _Measure
+_MeasureLayout(OpenFn &&open)
+{
+    const size_t rss = UsdProctestGetRss();
+    const size_t generatedBytes =
+        UsdProctestData::GetGlobalResidentBytes().GetTotal();
+
+    _Measure measure;
+    TfStopwatch stopwatch;
+    stopwatch.Start();
+    UsdStageRefPtr stage = open();
+    stopwatch.Stop();
+    TF_AXIOM(stage);
+
+    for (const UsdPrim &prim : stage->Traverse()) {
+        if (prim.IsA<UsdGeomMesh>()) {
+            ++measure.meshCount;
+        }
+    }
+    measure.seconds = stopwatch.GetSeconds();
+    const size_t currentRss = UsdProctestGetRss();
+    measure.rssBytes = currentRss > rss ? currentRss - rss : 0;
+    measure.generatedBytes =
+        UsdProctestData::GetGlobalResidentBytes().GetTotal() - generatedBytes;
+    return measure;
+}
+
+int
+main()
+{
+    const std::string dir =
+        ArchMakeTmpSubdir(ArchGetTmpDir(), "benchUsdProctestMerge");
+    TF_AXIOM(!dir.empty());
+
+    // The merged layout lists every cube in its proctest file, the one
+    // payload per cube layout references an empty proctest file with the
+    // side length of each cube as metadata. Cubes of the same side length
+    // share their payload layer.
+
+    const std::string mergedPath = TfStringCatPaths(dir, "merged.proctest");
+    {
+        std::ofstream merged(mergedPath.c_str());
+        for (int cube = 0; cube < cubeCount; ++cube) {
+            const GfVec3d translation = _GetTranslation(cube);
+            merged << _GetSideLength(cube) << " " << translation[0] << " "
+                   << translation[1] << " " << translation[2] << "\n";
+        }
+    }
+    const std::string cubePath = TfStringCatPaths(dir, "cube.proctest");
+    std::ofstream(cubePath.c_str()) << "# A single cube\n";
+
+    printf("%-20s %10s %10s %16s %16s\n", "layout", "meshes", "seconds",
+           "rss bytes", "generated bytes");
+
+    const _Measure merged = _MeasureLayout([&mergedPath]() {
+        return UsdStage::Open(mergedPath);
+    });
+    _Print("merged", merged);
+
+    const _Measure perCube = _MeasureLayout([&cubePath]() {
+        UsdStageRefPtr stage = UsdStage::CreateInMemory();
+        for (int cube = 0; cube < cubeCount; ++cube) {
+            UsdPrim prim = stage->DefinePrim(
+                SdfPath(TfStringPrintf("/Cube_%d", cube)));
+            prim.SetMetadata(TfToken("Usd_Proctest_SideLength"),
+                             _GetSideLength(cube));
+            UsdGeomXformable(prim).AddTranslateOp().Set(_GetTranslation(cube));
+            prim.GetPayloads().AddPayload(SdfPayload(cubePath));
+        }
+        return stage;
+    });
+    _Print("payload per cube", perCube);
+
+    TF_AXIOM(merged.meshCount == 1);
+    TF_AXIOM(perCube.meshCount == static_cast<size_t>(cubeCount));
+
+    TfRmTree(dir);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Test of the MyProcMesh regenerator: authored MyProcMesh prims get the
+// geometry of the generator in the session layer, once per flush unless
+// immediate, and prims of proctest payloads are left alone.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/notice.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/weakBase.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/notice.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/payload.h"
+#include "pxr/usd/usd/payloads.h"
+#include "pxr/usd/usd/attribute.h"
+#include "pxr/usd/usd/prim.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/tokens.h"
+#include "pxr/usd/usdProcTest/myProcMesh.h"
+#include "pxr/usd/usdProcTest/regenerator.h"
+
+#include "generator.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Count the change notices of a layer.
+class _LayerListener : public TfWeakBase {
+public:
+    explicit _LayerListener(const SdfLayerHandle &layer)
+        : _layer(layer)
+    {
+        TfNotice::Register(TfCreateWeakPtr(this), &_LayerListener::_OnChange);
+    }
+
+    size_t noticeCount = 0;
+
+private:
+    void _OnChange(const SdfNotice::LayersDidChange &notice)
+    {
+        for (const auto &entry : notice.GetChangeListVec()) {
+            if (entry.first == _layer) {
+                ++noticeCount;
+            }
+        }
+    }
+
+    SdfLayerHandle _layer;
+};
+
+// Return true if the session layer holds the generated points of the cube
+// at path.
+static bool
+_HasGeneratedPoints(const UsdStageRefPtr &stage, const SdfPath &path)
+{
+    const VtValue points = stage->GetSessionLayer()->GetField(
+        path.AppendProperty(UsdGeomTokens->points), SdfFieldKeys->Default);
+    const UsdProcTestMyProcMesh mesh(stage->GetPrimAtPath(path));
+    return mesh && points.IsHolding<VtVec3fArray>() &&
+           points.UncheckedGet<VtVec3fArray>() ==
+               UsdProctestGenerateCubePoints(mesh.GetCubeParams());
+}
+
+static void
+TestFallbacks()
+{
+    // The schema fallbacks are the defaults of the generator parameters, so
+    // unauthored attributes read as the parameters the file format uses.
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    const UsdProcTestMyProcMesh mesh =
+        UsdProcTestMyProcMesh::Define(stage, SdfPath("/Cube"));
+    const UsdProctestCubeParams defaults;
+    float length = 0.0f;
+    int divisions = 0;
+    TF_AXIOM(mesh.GetLengthAttr().Get(&length) && length == defaults.sideLength);
+    TF_AXIOM(mesh.GetDivisionsAttr().Get(&divisions) && divisions == defaults.divisions);
+}
+
+static void
+TestImmediate()
+{
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    const SdfPath path("/Cube");
+    UsdProcTestMyProcMesh mesh = UsdProcTestMyProcMesh::Define(stage, path);
+
+    UsdProcTestMyProcMeshRegenerator regenerator(stage, /* immediate = */ true);
+    regenerator.RegenerateAll();
+    TF_AXIOM(_HasGeneratedPoints(stage, path));
+
+    // Each unbatched edit regenerates, with its own notice.
+    _LayerListener listener(stage->GetSessionLayer());
+    mesh.CreateLengthAttr(VtValue(3.0f));
+    mesh.CreateDivisionsAttr(VtValue(4));
+    TF_AXIOM(listener.noticeCount == 2);
+    TF_AXIOM(_HasGeneratedPoints(stage, path));
+
+    // Edits in a change block regenerate once.
+    listener.noticeCount = 0;
+    {
+        SdfChangeBlock changeBlock;
+        mesh.GetLengthAttr().Set(2.0f);
+        mesh.GetDivisionsAttr().Set(6);
+    }
+    TF_AXIOM(listener.noticeCount == 1);
+    TF_AXIOM(_HasGeneratedPoints(stage, path));
+}
+
+static void
+TestCoalesced()
+{
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    const SdfPath path("/Cube");
+    UsdProcTestMyProcMesh mesh = UsdProcTestMyProcMesh::Define(stage, path);
+
+    // Unbatched edits only mark the prim dirty.
+    UsdProcTestMyProcMeshRegenerator regenerator(stage);
+    _LayerListener listener(stage->GetSessionLayer());
+    UsdAttribute lengthAttr = mesh.CreateLengthAttr(VtValue(1.0f));
+    for (int i = 0; i < 1000; ++i) {
+        lengthAttr.Set(1.0f + i);
+    }
+    TF_AXIOM(listener.noticeCount == 0);
+    TF_AXIOM(regenerator.GetDirtyPaths().count(path) == 1);
+
+    // A single regeneration for all of them.
+    regenerator.Flush();
+    TF_AXIOM(listener.noticeCount == 1);
+    TF_AXIOM(regenerator.GetDirtyPaths().empty());
+    TF_AXIOM(_HasGeneratedPoints(stage, path));
+
+    // A change block of the regenerator flushes when it closes.
+    listener.noticeCount = 0;
+    {
+        UsdProcTestMyProcMeshRegenerator::ChangeBlock changeBlock(regenerator);
+        lengthAttr.Set(2.0f);
+        mesh.CreateDivisionsAttr(VtValue(4));
+    }
+    TF_AXIOM(listener.noticeCount == 1);
+    TF_AXIOM(regenerator.GetDirtyPaths().empty());
+    TF_AXIOM(_HasGeneratedPoints(stage, path));
+}
+
+static void
+TestProctestPayload(const std::string &proctestPath)
+{
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    const SdfPath path("/Cube");
+    UsdPrim prim = stage->DefinePrim(path);
+    TF_AXIOM(prim.GetPayloads().AddPayload(SdfPayload(proctestPath)));
+    TF_AXIOM(prim.IsA<UsdProcTestMyProcMesh>());
+
+    UsdProcTestMyProcMeshRegenerator regenerator(stage);
+    regenerator.RegenerateAll();
+    TF_AXIOM(!stage->GetSessionLayer()->GetPrimAtPath(path));
+}
+
+int
+main()
+{
+    TestFallbacks();
+    TestImmediate();
+    TestCoalesced();
+
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProcTestRegenerator");
+    const std::string proctestPath = TfStringCatPaths(tmpDir, "cube.proctest");
+    {
+        std::ofstream out(proctestPath);
+        out << "# single cube\n";
+        TF_AXIOM(out);
+    }
+    TestProctestPayload(proctestPath);
+    TfRmTree(tmpDir);
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Test of the memory accounting of proctest layers: resident bytes go down
+// as cached values are evicted and layers released, generated on read
+// bytes accumulate, and the reporter samples them periodically, also while
+// layers are released.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "accounting.h"
+#include "data.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static void
+TestAccounting(const std::string &path)
+{
+    const size_t globalResident = UsdProctestGetGlobalGeneratedBytes().GetTotal();
+
+    SdfFileFormat::FileFormatArguments args;
+    args["Usd_Proctest_Divisions"] = "64";
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+    TF_AXIOM(layer);
+
+    UsdProctestGeneratedBytes generatedOnRead;
+    const UsdProctestGeneratedBytes resident =
+        UsdProctestGetGeneratedBytes(layer, &generatedOnRead);
+    TF_AXIOM(resident.points > 0);
+    TF_AXIOM(generatedOnRead.GetTotal() == 0);
+    TF_AXIOM(UsdProctestGetGlobalGeneratedBytes().GetTotal() ==
+             globalResident + resident.GetTotal());
+
+    // Without cache, each read of the implicit topology is generated again
+    // and accumulates, while resident bytes stay the same.
+    const SdfPath indicesPath =
+        SdfPath("/Root").AppendProperty(UsdGeomTokens->faceVertexIndices);
+    UsdProctestData::SetImplicitCacheBudget(0);
+    const VtValue indices = layer->GetField(indicesPath, SdfFieldKeys->Default);
+    const size_t indicesBytes = indices.Get<VtIntArray>().size() * sizeof(int);
+    layer->GetField(indicesPath, SdfFieldKeys->Default);
+    UsdProctestGetGeneratedBytes(layer, &generatedOnRead);
+    TF_AXIOM(generatedOnRead.topology == 2 * indicesBytes);
+    TF_AXIOM(UsdProctestGetGeneratedBytes(layer).GetTotal() == resident.GetTotal());
+
+    // Cached values are resident until evicted by a read under a smaller
+    // budget.
+    UsdProctestData::SetImplicitCacheBudget(indicesBytes);
+    layer->GetField(indicesPath, SdfFieldKeys->Default);
+    TF_AXIOM(UsdProctestGetGeneratedBytes(layer).GetTotal() ==
+             resident.GetTotal() + indicesBytes);
+    const SdfPath countsPath =
+        SdfPath("/Root").AppendProperty(UsdGeomTokens->faceVertexCounts);
+    layer->GetField(countsPath, SdfFieldKeys->Default);
+    const size_t cachedResident = UsdProctestGetGeneratedBytes(layer).GetTotal();
+    TF_AXIOM(cachedResident < resident.GetTotal() + indicesBytes);
+
+    // Releasing the layer releases its resident bytes.
+    layer.Reset();
+    TF_AXIOM(UsdProctestGetGlobalGeneratedBytes().GetTotal() == globalResident);
+}
+
+static void
+TestReporter(const std::string &path)
+{
+    std::atomic<size_t> sampleCount(0);
+    std::atomic<size_t> generatedSincePrevious(0);
+    {
+        UsdProctestGeneratedBytesReporter reporter(
+            0.01, [&](const UsdProctestGeneratedBytesSample &sample) {
+                generatedSincePrevious += sample.generatedOnReadSincePrevious.GetTotal();
+                ++sampleCount;
+            });
+
+        SdfFileFormat::FileFormatArguments args;
+        args["Usd_Proctest_Divisions"] = "16";
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+        TF_AXIOM(layer);
+        UsdProctestData::SetImplicitCacheBudget(0);
+        layer->GetField(SdfPath("/Root").AppendProperty(UsdGeomTokens->faceVertexIndices),
+                        SdfFieldKeys->Default);
+
+        UsdProctestGeneratedBytes generatedOnRead;
+        UsdProctestGetGeneratedBytes(layer, &generatedOnRead);
+        for (int i = 0; i < 1000 && generatedSincePrevious < generatedOnRead.GetTotal(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        TF_AXIOM(generatedSincePrevious == generatedOnRead.GetTotal());
+    }
+
+    // No sample after the reporter is destroyed.
+    const size_t finalSampleCount = sampleCount;
+    TF_AXIOM(finalSampleCount > 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TF_AXIOM(sampleCount == finalSampleCount);
+}
+
+static void
+TestReportWhileReleasing(const std::string &path)
+{
+    // Sampling enumerates the live data, never the layers, so layers may be
+    // released while a sample is taken.
+    std::atomic<size_t> sampleCount(0);
+    {
+        UsdProctestGeneratedBytesReporter reporter(
+            0.001, [&](const UsdProctestGeneratedBytesSample &) {
+                size_t resident = 0;
+                UsdProctestData::ForEachLiveData(
+                    [&](const UsdProctestData &data, const std::string &) {
+                        resident += data.GetResidentBytes().GetTotal();
+                    });
+                TF_AXIOM(resident <= UsdProctestGetGlobalGeneratedBytes().GetTotal());
+                ++sampleCount;
+            });
+
+        for (int i = 0; i < 100; ++i) {
+            SdfFileFormat::FileFormatArguments args;
+            args["Usd_Proctest_Divisions"] = std::to_string(2 + i % 8);
+            SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+            TF_AXIOM(layer);
+
+            bool found = false;
+            UsdProctestData::ForEachLiveData(
+                [&](const UsdProctestData &, const std::string &layerIdentifier) {
+                    found = found || layerIdentifier == layer->GetIdentifier();
+                });
+            TF_AXIOM(found);
+            TF_AXIOM(UsdProctestGetGeneratedBytes(layer).GetTotal() > 0);
+        }
+    }
+    TF_AXIOM(sampleCount > 0);
+}
+
+int
+main()
+{
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestAccounting");
+    const std::string path = TfStringCatPaths(tmpDir, "cube.proctest");
+    {
+        std::ofstream out(path);
+        out << "# single cube\n";
+        TF_AXIOM(out);
+    }
+
+    TestAccounting(path);
+    TestReporter(path);
+    TestReportWhileReleasing(path);
+
+    TfRmTree(tmpDir);
+
+    printf("OK\n");
+    return 0;
+}
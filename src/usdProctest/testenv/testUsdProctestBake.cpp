@@ -0,0 +1,127 @@
+// Test of the streaming bake: peak memory is bounded by the chunk size
+// rather than by the size of the cube, stale or partially deleted bakes
+// are not considered up to date, and bakes of other parameters to the
+// same path keep their own chunks.
+
+#include "testUtils.h"
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/vt/dictionary.h"
+#include "pxr/usd/sdf/layer.h"
+
+#include "bake.h"
+#include "generator.h"
+
+#include <cstdio>
+#include <string>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static size_t
+_GetGeometryBytes(const UsdProctestCubeParams &params, size_t faceCount)
+{
+    // faceVertexCounts and faceVertexIndices, then points.
+    return faceCount * 5 * sizeof(int) +
+           UsdProctestGetCubePointCount(params) * faceCount /
+               UsdProctestGetCubeFaceCount(params) * sizeof(GfVec3f);
+}
+
+static void
+TestPeakMemory(const std::string &dir)
+{
+    // Bake a small cube first, so that the memory used by the crate file
+    // format itself is not measured.
+    TF_AXIOM(UsdProctestBakeCube(UsdProctestCubeParams(),
+                                 TfStringCatPaths(dir, "warmup.usdc")));
+
+    UsdProctestCubeParams params;
+    params.divisions = 1024;
+    const size_t maxChunkFaces = 1 << 16;
+    const size_t cubeBytes =
+        _GetGeometryBytes(params, UsdProctestGetCubeFaceCount(params));
+    const size_t chunkBytes = _GetGeometryBytes(params, maxChunkFaces);
+
+    if (!UsdProctestResetPeakRss()) {
+        printf("Peak resident set size cannot be reset, skipping the peak "
+               "memory test\n");
+        return;
+    }
+    const size_t rss = UsdProctestGetRss();
+    TF_AXIOM(UsdProctestBakeCube(params, TfStringCatPaths(dir, "cube.usdc"),
+                                 maxChunkFaces));
+    const size_t peakRss = UsdProctestGetPeakRss();
+    const size_t bakeBytes = peakRss > rss ? peakRss - rss : 0;
+
+    printf("Baking %zu bytes of geometry in chunks of %zu bytes used %zu "
+           "bytes at peak\n", cubeBytes, chunkBytes, bakeBytes);
+
+    // A few chunks worth of memory for the generated arrays, the chunk
+    // layer and the crate writer buffers, far less than the whole cube.
+    TF_AXIOM(bakeBytes <= 8 * chunkBytes + (16 << 20));
+    TF_AXIOM(bakeBytes < cubeBytes / 4);
+}
+
+static void
+TestUpToDate(const std::string &dir)
+{
+    const std::string filePath = TfStringCatPaths(dir, "upToDate.usdc");
+    UsdProctestCubeParams params;
+    const std::string chunkPath = UsdProctestGetBakeChunkPath(params, filePath, 0);
+
+    TF_AXIOM(!UsdProctestIsBakeUpToDate(params, filePath));
+    TF_AXIOM(UsdProctestBakeCube(params, filePath));
+    TF_AXIOM(UsdProctestIsBakeUpToDate(params, filePath));
+
+    // A single division cube fits in a single chunk.
+    TF_AXIOM(TfIsFile(chunkPath));
+    TF_AXIOM(!TfIsFile(UsdProctestGetBakeChunkPath(params, filePath, 1)));
+
+    UsdProctestCubeParams otherParams = params;
+    otherParams.divisions = 2;
+    TF_AXIOM(!UsdProctestIsBakeUpToDate(otherParams, filePath));
+
+    // Baking other parameters to the same path keeps the chunks of the
+    // previous bake, which layers may still reference.
+    TF_AXIOM(UsdProctestGetBakeChunkPath(otherParams, filePath, 0) != chunkPath);
+    TF_AXIOM(UsdProctestBakeCube(otherParams, filePath));
+    TF_AXIOM(UsdProctestIsBakeUpToDate(otherParams, filePath));
+    TF_AXIOM(!UsdProctestIsBakeUpToDate(params, filePath));
+    TF_AXIOM(TfIsFile(chunkPath));
+    TF_AXIOM(UsdProctestBakeCube(params, filePath));
+
+    // A missing chunk is baked again.
+    TF_AXIOM(TfDeleteFile(chunkPath));
+    TF_AXIOM(!UsdProctestIsBakeUpToDate(params, filePath));
+    TF_AXIOM(UsdProctestBakeCube(params, filePath));
+    TF_AXIOM(UsdProctestIsBakeUpToDate(params, filePath));
+
+    // So is a bake made by another version of the generator.
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(filePath);
+    TF_AXIOM(layer);
+    VtDictionary customLayerData = layer->GetCustomLayerData();
+    customLayerData["proctest:generatorVersion"] =
+        VtValue(UsdProctestGeneratorVersion - 1);
+    layer->SetCustomLayerData(customLayerData);
+    TF_AXIOM(layer->Save());
+    TF_AXIOM(!UsdProctestIsBakeUpToDate(params, filePath));
+}
+
+int
+main()
+{
+    const std::string dir =
+        ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestBake");
+    TF_AXIOM(!dir.empty());
+
+    TestPeakMemory(dir);
+    TestUpToDate(dir);
+
+    TfRmTree(dir);
+    printf("OK\n");
+    return 0;
+}
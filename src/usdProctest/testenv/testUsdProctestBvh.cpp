@@ -0,0 +1,165 @@
+// Test of the bounding volume hierarchy over merged instances: queries
+// match a brute force search, the hierarchy round trips through prim
+// attributes, corrupt attributes are rejected, and invalid instances are
+// skipped when reading a layout.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/range3f.h"
+#include "pxr/base/gf/ray.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/usd/attribute.h"
+#include "pxr/usd/usd/prim.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static std::vector<GfRange3f>
+_MakeGrid(int size)
+{
+    std::vector<GfRange3f> bounds;
+    for (int z = 0; z < size; ++z) {
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const GfVec3f center(2.0f * x, 2.0f * y, 2.0f * z);
+                bounds.emplace_back(center - GfVec3f(0.5f),
+                                    center + GfVec3f(0.5f));
+            }
+        }
+    }
+    return bounds;
+}
+
+static std::vector<int>
+_BruteForceBox(const std::vector<GfRange3f> &bounds, const GfRange3f &box)
+{
+    std::vector<int> result;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (!GfRange3f::GetIntersection(box, bounds[i]).IsEmpty()) {
+            result.push_back(static_cast<int>(i));
+        }
+    }
+    return result;
+}
+
+static void
+TestQueries(const UsdProctestBvh &bvh, const std::vector<GfRange3f> &bounds)
+{
+    const std::vector<GfRange3f> boxes = {
+        GfRange3f(GfVec3f(-1.0f), GfVec3f(1.0f)),
+        GfRange3f(GfVec3f(1.0f, 1.0f, 1.0f), GfVec3f(5.2f, 3.0f, 9.0f)),
+        GfRange3f(GfVec3f(100.0f), GfVec3f(101.0f)),
+    };
+    const std::vector<std::vector<int>> results = bvh.QueryBoxes(boxes);
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        TF_AXIOM(bvh.QueryBox(boxes[i]) == _BruteForceBox(bounds, boxes[i]));
+        TF_AXIOM(results[i] == _BruteForceBox(bounds, boxes[i]));
+    }
+
+    // A ray along +X through the first row hits its instances in order.
+    const std::vector<int> hits =
+        bvh.QueryRay(GfRay(GfVec3d(-10.0, 0.0, 0.0), GfVec3d(1.0, 0.0, 0.0)));
+    TF_AXIOM(hits.size() == 8);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        TF_AXIOM(hits[i] == static_cast<int>(i));
+    }
+}
+
+static void
+TestCorruptAttributes(const UsdPrim &prim)
+{
+    UsdAttribute nodesAttr = prim.GetAttribute(UsdProctestBvhTokens->Nodes);
+    VtIntArray nodes;
+    TF_AXIOM(nodesAttr.Get(&nodes));
+
+    const auto isRejected = [&prim, &nodesAttr](const VtIntArray &corrupt) {
+        TF_AXIOM(nodesAttr.Set(corrupt));
+        UsdProctestBvh bvh;
+        return !UsdProctestBvh::Read(prim, &bvh);
+    };
+
+    // Second child of the root out of range, or pointing back at it.
+    VtIntArray corrupt = nodes;
+    corrupt[0] = static_cast<int>(nodes.size() / 2);
+    TF_AXIOM(isRejected(corrupt));
+    corrupt[0] = 0;
+    TF_AXIOM(isRejected(corrupt));
+
+    // Leaf items past the end of the items.
+    corrupt = nodes;
+    const size_t leaf = nodes.size() / 2 - 1;
+    corrupt[2 * leaf + 1] = 1000;
+    TF_AXIOM(isRejected(corrupt));
+    corrupt[2 * leaf + 1] = -1;
+    TF_AXIOM(isRejected(corrupt));
+
+    TF_AXIOM(!isRejected(nodes));
+}
+
+static void
+TestInvalidInstances()
+{
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestBvh");
+    const std::string path = TfStringCatPaths(tmpDir, "layout.proctest");
+    {
+        std::ofstream out(path);
+        out << "1 0 0 0\n"
+            << "0 3 0 0\n"      // zero side length
+            << "-1 6 0 0\n"     // negative side length
+            << "1e39 9 0 0\n"   // infinite as a float
+            << "1 12 0 1e400\n" // malformed, out of range
+            << "2 15 0 0\n";
+        TF_AXIOM(out);
+    }
+
+    // Only the two valid instances are merged, each with 6 faces.
+    {
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path);
+        TF_AXIOM(layer);
+        const VtValue counts = layer->GetField(
+            SdfPath("/Root").AppendProperty(UsdGeomTokens->faceVertexCounts),
+            SdfFieldKeys->Default);
+        TF_AXIOM(counts.IsHolding<VtIntArray>());
+        TF_AXIOM(counts.UncheckedGet<VtIntArray>().size() == 12);
+    }
+
+    TfRmTree(tmpDir);
+}
+
+int
+main()
+{
+    const std::vector<GfRange3f> bounds = _MakeGrid(8);
+    const UsdProctestBvh bvh = UsdProctestBvh::Build(bounds);
+    TF_AXIOM(!bvh.IsEmpty());
+    TestQueries(bvh, bounds);
+
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+    const UsdPrim prim = stage->DefinePrim(SdfPath("/Layout"));
+    TF_AXIOM(bvh.Write(prim));
+
+    UsdProctestBvh readBvh;
+    TF_AXIOM(UsdProctestBvh::Read(prim, &readBvh));
+    TestQueries(readBvh, bounds);
+
+    TestCorruptAttributes(prim);
+    TestInvalidInstances();
+
+    printf("OK\n");
+    return 0;
+}
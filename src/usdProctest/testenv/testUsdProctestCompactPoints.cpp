@@ -0,0 +1,76 @@
+// Test of points stored at a reduced precision: the decoded points are
+// within the reported error of the originals, and points beyond the range
+// of half floats are kept as floats rather than turned into infinities.
+
+#include "pxr/pxr.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/vt/array.h"
+
+#include "compactPoints.h"
+
+#include <cmath>
+#include <cstdio>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static VtVec3fArray
+_MakePoints(size_t count, float scale)
+{
+    VtVec3fArray points(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float t = static_cast<float>(i) / count;
+        points[i] = scale * GfVec3f(std::sin(7.0f * t), std::cos(5.0f * t), 2.0f * t - 1.0f);
+    }
+    return points;
+}
+
+static void
+TestEncode(const VtVec3fArray &points, const TfToken &precision)
+{
+    const UsdProctestCompactPoints compactPoints =
+        UsdProctestCompactPoints::Encode(points, precision);
+    TF_AXIOM(compactPoints.IsEncoded());
+    TF_AXIOM(compactPoints.GetSize() == points.size());
+    TF_AXIOM(compactPoints.GetSizeInBytes() < compactPoints.GetFullPrecisionSizeInBytes());
+
+    const VtVec3fArray decoded = compactPoints.Decode();
+    TF_AXIOM(decoded.size() == points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        TF_AXIOM(std::isfinite(decoded[i][0]) && std::isfinite(decoded[i][1]) &&
+                 std::isfinite(decoded[i][2]));
+        TF_AXIOM((decoded[i] - points[i]).GetLength() <= compactPoints.GetMaxError());
+    }
+    printf("%s: max error %g\n", precision.GetText(), compactPoints.GetMaxError());
+}
+
+static void
+TestHalfOutOfRange()
+{
+    // Larger than the largest half, which would decode as infinity.
+    const VtVec3fArray points = _MakePoints(100000, 70000.0f);
+
+    const UsdProctestCompactPoints compactPoints =
+        UsdProctestCompactPoints::Encode(points, UsdProctestPointsPrecisionTokens->Half);
+    TF_AXIOM(!compactPoints.IsEncoded());
+    TF_AXIOM(compactPoints.GetMaxError() == 0.0f);
+    TF_AXIOM(compactPoints.GetSizeInBytes() == compactPoints.GetFullPrecisionSizeInBytes());
+    TF_AXIOM(compactPoints.Decode() == points);
+
+    // Quantized points are relative to their bounds and have no such limit.
+    TestEncode(points, UsdProctestPointsPrecisionTokens->Quantized);
+}
+
+int
+main()
+{
+    // More points than a chunk, so that encoding spans several tasks.
+    const VtVec3fArray points = _MakePoints(100000, 10.0f);
+    TestEncode(points, UsdProctestPointsPrecisionTokens->Half);
+    TestEncode(points, UsdProctestPointsPrecisionTokens->Quantized);
+
+    TestHalfOutOfRange();
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+// Test of the implicit values of proctest layers: they are seen as authored
+// by queries that do not fetch them, follow their spec when it moves, and
+// are cached within the budget, except decoded compact points.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/sdf/types.h"
+#include "pxr/usd/usd/attribute.h"
+#include "pxr/usd/usd/resolveInfo.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usdGeom/mesh.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "data.h"
+#include "generator.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static void
+TestData()
+{
+    UsdProctestCubeParams params;
+    params.divisions = 4;
+    const SdfPath attrPath =
+        SdfPath("/Cube").AppendProperty(UsdGeomTokens->faceVertexIndices);
+    const SdfPath movedPath = SdfPath("/Cube").AppendProperty(TfToken("moved"));
+
+    UsdProctestDataRefPtr data = UsdProctestData::New();
+    data->CreateSpec(attrPath.GetPrimPath(), SdfSpecTypePrim);
+    data->CreateSpec(attrPath, SdfSpecTypeAttribute);
+    data->Set(attrPath, SdfFieldKeys->TypeName,
+              VtValue(SdfValueTypeNames->IntArray.GetAsToken()));
+    data->SetImplicitDefault(attrPath, [params]() {
+        return VtValue::Take(UsdProctestGenerateCubeFaceVertexIndices(
+            params, UsdProctestGetCubeRange(params)));
+    });
+
+    // The type is known without generating the value.
+    TF_AXIOM(data->GetTypeid(attrPath, SdfFieldKeys->Default) ==
+             typeid(VtIntArray));
+    TF_AXIOM(data->Has(attrPath, SdfFieldKeys->Default));
+    TF_AXIOM(data->GetGeneratedOnReadBytes().GetTotal() == 0);
+
+    // Repeated reads are served by the cache.
+    UsdProctestData::SetImplicitCacheBudget(1 << 20);
+    const VtValue value = data->Get(attrPath, SdfFieldKeys->Default);
+    const size_t generatedBytes = data->GetGeneratedOnReadBytes().topology;
+    TF_AXIOM(generatedBytes == value.Get<VtIntArray>().size() * sizeof(int));
+    TF_AXIOM(data->Get(attrPath, SdfFieldKeys->Default) == value);
+    TF_AXIOM(data->GetGeneratedOnReadBytes().topology == generatedBytes);
+    TF_AXIOM(data->GetResidentBytes().topology == generatedBytes);
+
+    // Moving the attribute moves its implicit value, and releases the
+    // cached one. Without budget, it is not cached again.
+    UsdProctestData::SetImplicitCacheBudget(0);
+    data->MoveSpec(attrPath, movedPath);
+    TF_AXIOM(!data->HasImplicitDefault(attrPath));
+    TF_AXIOM(!data->Has(attrPath, SdfFieldKeys->Default));
+    TF_AXIOM(data->HasImplicitDefault(movedPath));
+    TF_AXIOM(data->Get(movedPath, SdfFieldKeys->Default) == value);
+    TF_AXIOM(data->GetResidentBytes().GetTotal() == 0);
+
+    // Authoring replaces the implicit value.
+    data->Set(movedPath, SdfFieldKeys->Default, VtValue(VtIntArray(3, 1)));
+    TF_AXIOM(!data->HasImplicitDefault(movedPath));
+    TF_AXIOM(data->GetResidentBytes().primvars == 3 * sizeof(int));
+}
+
+// Return data holding the face vertex indices of a cube as an implicit
+// value at /Cube.
+static UsdProctestDataRefPtr
+_MakeCubeData(const UsdProctestCubeParams &params)
+{
+    const SdfPath attrPath =
+        SdfPath("/Cube").AppendProperty(UsdGeomTokens->faceVertexIndices);
+    UsdProctestDataRefPtr data = UsdProctestData::New();
+    data->CreateSpec(attrPath.GetPrimPath(), SdfSpecTypePrim);
+    data->CreateSpec(attrPath, SdfSpecTypeAttribute);
+    data->Set(attrPath, SdfFieldKeys->TypeName,
+              VtValue(SdfValueTypeNames->IntArray.GetAsToken()));
+    data->SetImplicitDefault(attrPath, [params]() {
+        return VtValue::Take(UsdProctestGenerateCubeFaceVertexIndices(
+            params, UsdProctestGetCubeRange(params)));
+    });
+    return data;
+}
+
+static void
+TestSharedCache()
+{
+    UsdProctestCubeParams params;
+    params.divisions = 8;
+    const size_t valueBytes = 4 * UsdProctestGetCubeFaceCount(params) * sizeof(int);
+    const SdfPath attrPath =
+        SdfPath("/Cube").AppendProperty(UsdGeomTokens->faceVertexIndices);
+
+    // Room for a single value, over all data.
+    UsdProctestData::SetImplicitCacheBudget(valueBytes);
+
+    UsdProctestDataRefPtr first = _MakeCubeData(params);
+    first->Get(attrPath, SdfFieldKeys->Default);
+    TF_AXIOM(first->GetResidentBytes().topology == valueBytes);
+
+    // Reads of a second data evict the value cached by the first one,
+    // whose next read is generated again.
+    UsdProctestDataRefPtr second = _MakeCubeData(params);
+    second->Get(attrPath, SdfFieldKeys->Default);
+    TF_AXIOM(second->GetResidentBytes().topology == valueBytes);
+    TF_AXIOM(first->GetResidentBytes().topology == 0);
+
+    first->Get(attrPath, SdfFieldKeys->Default);
+    TF_AXIOM(first->GetGeneratedOnReadBytes().topology == 2 * valueBytes);
+    TF_AXIOM(second->GetResidentBytes().topology == 0);
+
+    // Reducing the budget evicts the values of every data.
+    UsdProctestData::SetImplicitCacheBudget(0);
+    TF_AXIOM(first->GetResidentBytes().topology == 0);
+    TF_AXIOM(second->GetResidentBytes().topology == 0);
+}
+
+static void
+TestUncacheable(const std::string &dir)
+{
+    UsdProctestData::SetImplicitCacheBudget(64 << 20);
+
+    // Decoded compact points are generated on every read rather than
+    // cached, so that only the compact points stay resident.
+    const std::string filePath = TfStringCatPaths(dir, "halfPoints.proctest");
+    std::ofstream(filePath.c_str()) << "# A single cube\n";
+    SdfFileFormat::FileFormatArguments args;
+    args["Usd_Proctest_Divisions"] = "16";
+    args["Usd_Proctest_PointsPrecision"] = "half";
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(filePath, args);
+    TF_AXIOM(layer);
+
+    const SdfPath pointsPath = SdfPath("/Root").AppendProperty(UsdGeomTokens->points);
+    bool found = false;
+    UsdProctestGeneratedBytes resident;
+    const auto getBytes = [&](UsdProctestGeneratedBytes *generatedOnRead) {
+        found = false;
+        UsdProctestData::ForEachLiveData(
+            [&](const UsdProctestData &data, const std::string &layerIdentifier) {
+                if (!found && layerIdentifier == layer->GetIdentifier()) {
+                    TF_AXIOM(data.HasImplicitDefault(pointsPath));
+                    resident = data.GetResidentBytes();
+                    *generatedOnRead = data.GetGeneratedOnReadBytes();
+                    found = true;
+                }
+            });
+        TF_AXIOM(found);
+    };
+
+    UsdProctestGeneratedBytes generatedOnRead;
+    getBytes(&generatedOnRead);
+    const size_t compactBytes = resident.points;
+    TF_AXIOM(compactBytes > 0);
+
+    const VtValue points = layer->GetField(pointsPath, SdfFieldKeys->Default);
+    const size_t pointsBytes = points.Get<VtVec3fArray>().size() * sizeof(GfVec3f);
+    TF_AXIOM(compactBytes < pointsBytes);
+    layer->GetField(pointsPath, SdfFieldKeys->Default);
+    getBytes(&generatedOnRead);
+    TF_AXIOM(generatedOnRead.points == 2 * pointsBytes);
+    TF_AXIOM(resident.points == compactBytes);
+
+    UsdProctestData::SetImplicitCacheBudget(0);
+}
+
+static void
+TestLayer(const std::string &dir)
+{
+    const std::string filePath = TfStringCatPaths(dir, "cube.proctest");
+    std::ofstream(filePath.c_str()) << "# A single cube\n";
+
+    UsdStageRefPtr stage = UsdStage::Open(filePath);
+    TF_AXIOM(stage);
+    const UsdGeomMesh mesh(stage->GetPrimAtPath(SdfPath("/Root")));
+    TF_AXIOM(mesh);
+
+    // Queries that check for a default without fetching it see the
+    // implicit values as authored.
+    for (const UsdAttribute &attr : {mesh.GetFaceVertexCountsAttr(),
+                                     mesh.GetFaceVertexIndicesAttr()}) {
+        TF_AXIOM(attr.HasAuthoredValue());
+        TF_AXIOM(attr.GetResolveInfo().GetSource() ==
+                 UsdResolveInfoSourceDefault);
+        TF_AXIOM(stage->GetRootLayer()->GetFieldTypeid(
+                     attr.GetPath(), SdfFieldKeys->Default) ==
+                 typeid(VtIntArray));
+    }
+}
+
+int
+main()
+{
+    const std::string dir =
+        ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestData");
+    TF_AXIOM(!dir.empty());
+
+    TestData();
+    TestSharedCache();
+    TestUncacheable(dir);
+    TestLayer(dir);
+
+    TfRmTree(dir);
+    printf("OK\n");
+    return 0;
+}
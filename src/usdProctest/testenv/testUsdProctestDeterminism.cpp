@@ -0,0 +1,243 @@
+// Test of the determinism of generation: configurations covering the code
+// paths of the generator are generated with each concurrency limit from 1
+// to N threads, N being the first argument or the number of cores, and
+// must hash the same at every limit. Their content hashes must also tell
+// apart different content, baked content included.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/arch/hash.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/base/vt/dictionary.h"
+#include "pxr/base/work/threadLimits.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+
+#include "bake.h"
+#include "generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// A configuration of the generator: the file format arguments of a proctest
+// layer and the content of its proctest file.
+struct _Config {
+    std::string name;
+    SdfFileFormat::FileFormatArguments args;
+    std::string fileContent;
+};
+
+// Configurations covering the code paths of the generator: single and
+// merged cubes, cubes spanning many parallel chunks, velocities, side
+// subsets, reduced precision points and levels of detail.
+static std::vector<_Config>
+_GetConfigs()
+{
+    return {
+        {"default", {}, ""},
+        {"chunked", {{"Usd_Proctest_SideLength", "2.5"}, {"Usd_Proctest_Divisions", "300"}}, ""},
+        {"velocities",
+         {{"Usd_Proctest_Divisions", "100"}, {"Usd_Proctest_SideLengthRate", "0.5"}}, ""},
+        {"sideSubsets",
+         {{"Usd_Proctest_Divisions", "100"}, {"Usd_Proctest_SideSubsets", "1"}}, ""},
+        {"half", {{"Usd_Proctest_Divisions", "200"}, {"Usd_Proctest_PointsPrecision", "half"}},
+         ""},
+        {"quantized",
+         {{"Usd_Proctest_Divisions", "200"}, {"Usd_Proctest_PointsPrecision", "quantized"}}, ""},
+        {"lod",
+         {{"Usd_Proctest_Divisions", "200"}, {"Usd_Proctest_LodCount", "3"},
+          {"Usd_Proctest_Lod", "1"}},
+         ""},
+        {"merged", {{"Usd_Proctest_Divisions", "20"}, {"Usd_Proctest_SideSubsets", "1"}},
+         "1 0 0 0\n"
+         "0.5 2 0 0\n"
+         "2 0 3 0\n"
+         "1 0.8 0 0 0 0 0.8 0 0 0 0 0.8 0 -2 1 0 1\n"},
+    };
+}
+
+template <typename T>
+static bool
+_HashArray(const VtValue &value, uint64_t *hash)
+{
+    if (!value.IsHolding<VtArray<T>>()) {
+        return false;
+    }
+    const VtArray<T> &array = value.UncheckedGet<VtArray<T>>();
+    *hash = ArchHash64(reinterpret_cast<const char *>(array.cdata()),
+                       array.size() * sizeof(T), *hash);
+    return true;
+}
+
+// Hash the generated arrays by content, other values by their text.
+static uint64_t
+_HashValue(const VtValue &value, uint64_t hash)
+{
+    if (_HashArray<GfVec3f>(value, &hash) || _HashArray<int>(value, &hash) ||
+        _HashArray<float>(value, &hash)) {
+        return hash;
+    }
+    const std::string text = TfStringify(value);
+    return ArchHash64(text.c_str(), text.size(), hash);
+}
+
+// Hash every field of every spec of layer, implicit values included, in a
+// canonical order.
+static uint64_t
+_HashLayer(const SdfLayerHandle &layer)
+{
+    std::vector<SdfPath> paths;
+    layer->Traverse(SdfPath::AbsoluteRootPath(),
+                    [&paths](const SdfPath &path) { paths.push_back(path); });
+    std::sort(paths.begin(), paths.end());
+
+    uint64_t hash = 0;
+    for (const SdfPath &path : paths) {
+        hash = ArchHash64(path.GetText(), path.GetString().size(), hash);
+
+        std::vector<TfToken> fields = layer->ListFields(path);
+        std::sort(fields.begin(), fields.end());
+        for (const TfToken &field : fields) {
+            hash = ArchHash64(field.GetText(), field.size(), hash);
+            hash = _HashValue(layer->GetField(path, field), hash);
+        }
+    }
+    return hash;
+}
+
+static std::string
+_GetContentHash(const SdfLayerHandle &layer)
+{
+    const VtDictionary customLayerData = layer->GetCustomLayerData();
+    TF_AXIOM(VtDictionaryIsHolding<std::string>(customLayerData, "proctest:contentHash"));
+    return VtDictionaryGet<std::string>(customLayerData, "proctest:contentHash");
+}
+
+static std::string
+_WriteProctestFile(const std::string &dir, const _Config &config)
+{
+    const std::string path = TfStringCatPaths(dir, config.name + ".proctest");
+    std::ofstream out(path);
+    out << config.fileContent;
+    TF_AXIOM(out);
+    return path;
+}
+
+// Generate every configuration with each concurrency limit from 1 to
+// maxThreads and return the number of mismatches. Configurations must also
+// have distinct content hashes.
+static int
+TestDeterminism(const std::string &dir, size_t maxThreads)
+{
+    int mismatchCount = 0;
+    std::set<std::string> contentHashes;
+    for (const _Config &config : _GetConfigs()) {
+        const std::string identifier =
+            SdfLayer::CreateIdentifier(_WriteProctestFile(dir, config), config.args);
+
+        uint64_t referenceHash = 0;
+        std::string referenceContentHash;
+        for (size_t threads = 1; threads <= maxThreads; ++threads) {
+            WorkSetConcurrencyLimit(static_cast<unsigned>(threads));
+
+            // The layer is released at the end of each iteration, so that
+            // the next one generates it again.
+            SdfLayerRefPtr layer = SdfLayer::FindOrOpen(identifier);
+            TF_AXIOM(layer);
+
+            const uint64_t hash = _HashLayer(layer);
+            const std::string contentHash = _GetContentHash(layer);
+            if (threads == 1) {
+                referenceHash = hash;
+                referenceContentHash = contentHash;
+                TF_AXIOM(contentHashes.insert(contentHash).second);
+            } else if (hash != referenceHash || contentHash != referenceContentHash) {
+                fprintf(stderr, "Configuration '%s' generated with %zu threads differs "
+                        "from the one generated with 1 thread\n",
+                        config.name.c_str(), threads);
+                ++mismatchCount;
+            }
+        }
+        printf("%s: %zu thread limits\n", config.name.c_str(), maxThreads);
+    }
+
+    WorkSetMaximumConcurrencyLimit();
+    return mismatchCount;
+}
+
+// The content hash of a baked cube changes when its bake is rewritten.
+static void
+TestBakeContentHash(const std::string &dir)
+{
+    const _Config config = {"baked",
+                            {{"Usd_Proctest_Divisions", "8"},
+                             {"Usd_Proctest_BakePath", "baked.usdc"}},
+                            ""};
+    const std::string identifier =
+        SdfLayer::CreateIdentifier(_WriteProctestFile(dir, config), config.args);
+
+    std::string contentHash;
+    {
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(identifier);
+        TF_AXIOM(layer);
+        contentHash = _GetContentHash(layer);
+
+        // Like a generated single cube, the baked cube is a MyProcMesh.
+        const SdfPrimSpecHandle root = layer->GetPrimAtPath(SdfPath("/Root"));
+        TF_AXIOM(root && root->GetTypeName() == TfToken("MyProcMesh"));
+    }
+
+    // Reopened as is, the bake is up to date and kept.
+    {
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(identifier);
+        TF_AXIOM(layer);
+        TF_AXIOM(_GetContentHash(layer) == contentHash);
+    }
+
+    // Once rebaked, the same arguments hash differently.
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    UsdProctestCubeParams params;
+    params.divisions = 8;
+    TF_AXIOM(TfDeleteFile(
+        UsdProctestGetBakeChunkPath(params, TfStringCatPaths(dir, "baked.usdc"), 0)));
+    {
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(identifier);
+        TF_AXIOM(layer);
+        TF_AXIOM(_GetContentHash(layer) != contentHash);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    const size_t maxThreads = argc > 1
+        ? static_cast<size_t>(std::max(1, std::atoi(argv[1])))
+        : std::max<size_t>(2, WorkGetPhysicalConcurrencyLimit());
+
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestDeterminism");
+    const int mismatchCount = TestDeterminism(tmpDir, maxThreads);
+    TestBakeContentHash(tmpDir);
+    TfRmTree(tmpDir);
+
+    if (mismatchCount != 0) {
+        fprintf(stderr, "%d mismatches\n", mismatchCount);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+// Test of the levels of detail of proctest layers: the lod variant set has
+// one variant per distinct level, more levels being clamped, divisions
+// halve from one level to the next, and only the selected level is
+// generated at load.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/sdf/schema.h"
+#include "pxr/usd/usd/prim.h"
+#include "pxr/usd/usd/stage.h"
+#include "pxr/usd/usd/variantSets.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "data.h"
+#include "generator.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static void
+TestLodCount()
+{
+    UsdProctestCubeParams params;
+    const std::vector<std::pair<int, int>> expected = {
+        {1, 1}, {2, 2}, {3, 2}, {7, 3}, {8, 4}, {1024, 11},
+    };
+    for (const auto &divisionsAndCount : expected) {
+        params.divisions = divisionsAndCount.first;
+        TF_AXIOM(UsdProctestGetCubeLodCount(params) == divisionsAndCount.second);
+
+        // The last level is a single quad per side, unlike the one before.
+        const int last = divisionsAndCount.second - 1;
+        TF_AXIOM(UsdProctestGetCubeLodParams(params, last).divisions == 1);
+        if (last > 0) {
+            TF_AXIOM(UsdProctestGetCubeLodParams(params, last - 1).divisions > 1);
+        }
+    }
+}
+
+// Return the lod variants of the cube of path with divisions and lodCount.
+static std::vector<std::string>
+_GetLodVariants(const std::string &path, int divisions, int lodCount)
+{
+    SdfFileFormat::FileFormatArguments args;
+    args["Usd_Proctest_Divisions"] = TfStringify(divisions);
+    args["Usd_Proctest_LodCount"] = TfStringify(lodCount);
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+    TF_AXIOM(layer);
+
+    UsdStageRefPtr stage = UsdStage::Open(layer);
+    const UsdPrim prim = stage->GetDefaultPrim();
+    TF_AXIOM(prim);
+    if (!prim.GetVariantSets().HasVariantSet("lod")) {
+        return {};
+    }
+    return prim.GetVariantSet("lod").GetVariantNames();
+}
+
+static void
+TestLodVariants(const std::string &path)
+{
+    const std::vector<std::string> variants = _GetLodVariants(path, 8, 3);
+    TF_AXIOM((variants == std::vector<std::string>{"lod0", "lod1", "lod2"}));
+
+    // 8 divisions have 4 distinct levels, down to 1 division.
+    const std::vector<std::string> clampedVariants = _GetLodVariants(path, 8, 10);
+    TF_AXIOM((clampedVariants == std::vector<std::string>{"lod0", "lod1", "lod2", "lod3"}));
+
+    // A single division has a single level, and no variant set.
+    TF_AXIOM(_GetLodVariants(path, 1, 4).empty());
+}
+
+static void
+TestLazyLevels(const std::string &path)
+{
+    const int divisions = 8;
+    const int lodCount = 4;
+    const int lod = 1;
+    SdfFileFormat::FileFormatArguments args;
+    args["Usd_Proctest_Divisions"] = TfStringify(divisions);
+    args["Usd_Proctest_LodCount"] = TfStringify(lodCount);
+    args["Usd_Proctest_Lod"] = TfStringify(lod);
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+    TF_AXIOM(layer);
+
+    const auto getPropertyPath = [](int level, const TfToken &name) {
+        return SdfPath("/Root")
+            .AppendVariantSelection("lod", TfStringPrintf("lod%d", level))
+            .AppendProperty(name);
+    };
+
+    // Only the points of the selected level are stored, those of the other
+    // levels and the topology of all levels are implicit. Nothing was
+    // generated on read nor cached, so the resident bytes are the selected
+    // points only.
+    UsdProctestCubeParams params;
+    params.divisions = divisions;
+    const size_t selectedPointsBytes =
+        UsdProctestGetCubePointCount(UsdProctestGetCubeLodParams(params, lod)) *
+        sizeof(GfVec3f);
+    bool found = false;
+    UsdProctestData::ForEachLiveData(
+        [&](const UsdProctestData &data, const std::string &layerIdentifier) {
+            if (found || layerIdentifier != layer->GetIdentifier()) {
+                return;
+            }
+            found = true;
+            for (int level = 0; level < lodCount; ++level) {
+                TF_AXIOM(data.HasImplicitDefault(getPropertyPath(level, UsdGeomTokens->points)) ==
+                         (level != lod));
+                TF_AXIOM(data.HasImplicitDefault(
+                    getPropertyPath(level, UsdGeomTokens->faceVertexCounts)));
+                TF_AXIOM(data.HasImplicitDefault(
+                    getPropertyPath(level, UsdGeomTokens->faceVertexIndices)));
+            }
+            TF_AXIOM(data.GetGeneratedOnReadBytes().GetTotal() == 0);
+            TF_AXIOM(data.GetResidentBytes().points == selectedPointsBytes);
+            TF_AXIOM(data.GetResidentBytes().topology == 0);
+        });
+    TF_AXIOM(found);
+
+    // Divisions halve from one level to the next.
+    for (int level = 0; level < lodCount; ++level) {
+        const int levelDivisions = divisions >> level;
+        TF_AXIOM(UsdProctestGetCubeLodParams(params, level).divisions == levelDivisions);
+        const VtValue counts =
+            layer->GetField(getPropertyPath(level, UsdGeomTokens->faceVertexCounts),
+                            SdfFieldKeys->Default);
+        TF_AXIOM(counts.IsHolding<VtIntArray>());
+        TF_AXIOM(counts.UncheckedGet<VtIntArray>().size() ==
+                 static_cast<size_t>(6 * levelDivisions * levelDivisions));
+    }
+}
+
+int
+main()
+{
+    TestLodCount();
+
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestLod");
+    const std::string path = TfStringCatPaths(tmpDir, "cube.proctest");
+    {
+        std::ofstream out(path);
+        out << "# single cube\n";
+        TF_AXIOM(out);
+    }
+    TestLodVariants(path);
+    TestLazyLevels(path);
+    TfRmTree(tmpDir);
+
+    printf("OK\n");
+    return 0;
+}
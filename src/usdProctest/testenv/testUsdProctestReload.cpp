@@ -0,0 +1,165 @@
+// Test of forced reloads of unchanged proctest layers: they keep their
+// data instead of regenerating it, while Sdf still notifies that their
+// content was reloaded, and a changed file is regenerated into new data
+// that replaces the previous one.
+
+#include "pxr/pxr.h"
+#include "pxr/base/arch/fileSystem.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/tf/fileUtils.h"
+#include "pxr/base/tf/notice.h"
+#include "pxr/base/tf/pathUtils.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/base/tf/weakBase.h"
+#include "pxr/usd/sdf/fileFormat.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/notice.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/usdGeom/tokens.h"
+
+#include "data.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+static const size_t layerCount = 10000;
+
+// Count the layers whose content was reported reloaded.
+class _ReloadListener : public TfWeakBase {
+public:
+    _ReloadListener()
+    {
+        TfNotice::Register(TfCreateWeakPtr(this), &_ReloadListener::_OnChange);
+    }
+
+    size_t reloadedCount = 0;
+
+private:
+    void _OnChange(const SdfNotice::LayersDidChange &notice)
+    {
+        for (const auto &entry : notice.GetChangeListVec()) {
+            for (const auto &pathEntry : entry.second.GetEntryList()) {
+                if (pathEntry.second.flags.didReloadContent) {
+                    ++reloadedCount;
+                    break;
+                }
+            }
+        }
+    }
+};
+
+static void
+_WriteProctestFile(const std::string &path, const std::string &content)
+{
+    std::ofstream out(path);
+    out << content;
+    TF_AXIOM(out);
+}
+
+// The data of a layer, as found among the live proctest data.
+struct _LayerDataInfo {
+    bool found = false;
+    uint64_t fingerprint = 0;
+    bool implicitPoints = false;
+    bool implicitTopology = false;
+};
+
+static _LayerDataInfo
+_GetLayerDataInfo(const SdfLayerHandle &layer)
+{
+    const SdfPath rootPath("/Root");
+    _LayerDataInfo info;
+    UsdProctestData::ForEachLiveData(
+        [&](const UsdProctestData &data, const std::string &layerIdentifier) {
+            if (info.found || layerIdentifier != layer->GetIdentifier()) {
+                return;
+            }
+            info.found = true;
+            info.fingerprint = data.GetFingerprint();
+            info.implicitPoints =
+                data.HasImplicitDefault(rootPath.AppendProperty(UsdGeomTokens->points));
+            info.implicitTopology =
+                data.HasImplicitDefault(
+                    rootPath.AppendProperty(UsdGeomTokens->faceVertexCounts)) &&
+                data.HasImplicitDefault(
+                    rootPath.AppendProperty(UsdGeomTokens->faceVertexIndices));
+        });
+    return info;
+}
+
+int
+main()
+{
+    const std::string tmpDir = ArchMakeTmpSubdir(ArchGetTmpDir(), "testUsdProctestReload");
+    const std::string path = TfStringCatPaths(tmpDir, "cube.proctest");
+    _WriteProctestFile(path, "# single cube\n");
+
+    // Distinct arguments so that each layer has its own data.
+    std::vector<SdfLayerRefPtr> layers;
+    layers.reserve(layerCount);
+    for (size_t i = 0; i < layerCount; ++i) {
+        SdfFileFormat::FileFormatArguments args;
+        args["Usd_Proctest_Divisions"] = "1";
+        // Half precision points are implicit, decoded on read.
+        args["Usd_Proctest_PointsPrecision"] = "half";
+        args["Usd_Proctest_SideLength"] = TfStringify(1.0 + i);
+        SdfLayerRefPtr layer = SdfLayer::FindOrOpen(path, args);
+        TF_AXIOM(layer);
+        layers.push_back(layer);
+    }
+
+    const size_t createdCount = UsdProctestData::GetCreatedCount();
+    TF_AXIOM(UsdProctestData::GetLiveCount() >= layerCount);
+
+    // Forced reloads of unchanged layers create no data. The reload notice
+    // is still sent, so stages still resync the prims using these layers.
+    {
+        _ReloadListener listener;
+        for (const SdfLayerRefPtr &layer : layers) {
+            TF_AXIOM(layer->Reload(/* force = */ true));
+        }
+        printf("%zu data created by %zu reloads, %zu reload notices\n",
+               UsdProctestData::GetCreatedCount() - createdCount, layerCount,
+               listener.reloadedCount);
+        TF_AXIOM(UsdProctestData::GetCreatedCount() == createdCount);
+        TF_AXIOM(listener.reloadedCount == layerCount);
+    }
+
+    // A changed proctest file, seen through its modification time, is
+    // regenerated. The new data replaces the previous one, with its
+    // fingerprint and implicit values, instead of being diffed into it.
+    const _LayerDataInfo previous = _GetLayerDataInfo(layers.front());
+    TF_AXIOM(previous.found);
+    TF_AXIOM(previous.implicitPoints && previous.implicitTopology);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    _WriteProctestFile(path, "# single cube, edited\n");
+    TF_AXIOM(layers.front()->Reload(/* force = */ true));
+    TF_AXIOM(UsdProctestData::GetCreatedCount() == createdCount + 1);
+    const _LayerDataInfo changed = _GetLayerDataInfo(layers.front());
+    TF_AXIOM(changed.found);
+    TF_AXIOM(changed.fingerprint != previous.fingerprint);
+    TF_AXIOM(changed.implicitPoints && changed.implicitTopology);
+
+    // The layer now holds the new fingerprint, so forcing another reload of
+    // the changed file creates no data.
+    TF_AXIOM(layers.front()->Reload(/* force = */ true));
+    TF_AXIOM(UsdProctestData::GetCreatedCount() == createdCount + 1);
+    TF_AXIOM(_GetLayerDataInfo(layers.front()).fingerprint == changed.fingerprint);
+
+    // Released layers release their data.
+    const size_t liveCount = UsdProctestData::GetLiveCount();
+    layers.clear();
+    TF_AXIOM(UsdProctestData::GetLiveCount() + layerCount <= liveCount);
+
+    TfRmTree(tmpDir);
+
+    printf("OK\n");
+    return 0;
+}
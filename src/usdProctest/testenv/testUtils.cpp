@@ -0,0 +1,173 @@
+#include "testUtils.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::atomic<size_t> _allocationCount(0);
+std::atomic<size_t> _allocatedBytes(0);
+std::atomic<size_t> _largeAllocationCount(0);
+std::atomic<size_t> _largeAllocationSize(static_cast<size_t>(-1));
+
+void
+_CountAllocation(size_t size)
+{
+    _allocationCount.fetch_add(1, std::memory_order_relaxed);
+    _allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size >= _largeAllocationSize.load(std::memory_order_relaxed)) {
+        _largeAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // anonymous namespace
+
+#if defined(__GLIBC__)
+
+// Definitions in the executable take precedence over those of the C
+// library for every shared library of the process, so that VtArray, which
+// allocates with malloc, and operator new, which calls it, are counted.
+// The glibc entry points are the actual allocator.
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+
+void *
+malloc(size_t size)
+{
+    _CountAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t count, size_t size)
+{
+    _CountAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+    _CountAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *
+memalign(size_t alignment, size_t size)
+{
+    _CountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *
+aligned_alloc(size_t alignment, size_t size)
+{
+    _CountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 ||
+        (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    _CountAllocation(size);
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void
+free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+} // extern "C"
+
+#endif
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Return the value in bytes of the field of /proc/self/status, given in kB.
+size_t
+_GetProcStatusBytes(const std::string &field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.size(), field) == 0 &&
+            line.size() > field.size() && line[field.size()] == ':') {
+            std::istringstream value(line.substr(field.size() + 1));
+            size_t kiloBytes = 0;
+            value >> kiloBytes;
+            return kiloBytes * 1024;
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+bool
+UsdProctestHasAllocationCounts()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+UsdProctestAllocations
+UsdProctestGetAllocations()
+{
+    UsdProctestAllocations allocations;
+    allocations.count = _allocationCount.load(std::memory_order_relaxed);
+    allocations.bytes = _allocatedBytes.load(std::memory_order_relaxed);
+    allocations.largeCount =
+        _largeAllocationCount.load(std::memory_order_relaxed);
+    return allocations;
+}
+
+void
+UsdProctestSetLargeAllocationSize(size_t bytes)
+{
+    _largeAllocationSize.store(bytes, std::memory_order_relaxed);
+}
+
+size_t
+UsdProctestGetRss()
+{
+    return _GetProcStatusBytes("VmRSS");
+}
+
+size_t
+UsdProctestGetPeakRss()
+{
+    return _GetProcStatusBytes("VmHWM");
+}
+
+bool
+UsdProctestResetPeakRss()
+{
+    // Writing 5 to clear_refs resets the peak resident set size, on Linux
+    // 4.0 and later.
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    return static_cast<bool>(clearRefs << "5" << std::flush);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,41 @@
+#ifndef USDPROCTEST_TESTENV_TESTUTILS_H
+#define USDPROCTEST_TESTENV_TESTUTILS_H
+
+#include "pxr/pxr.h"
+
+#include <cstddef>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Allocations made since the process started, counted by replacements of
+// malloc and its variants linked into every test, which see the storage of
+// VtArray as well as that of operator new. largeCount counts the
+// allocations of at least the large allocation size.
+struct UsdProctestAllocations {
+    size_t count = 0;
+    size_t bytes = 0;
+    size_t largeCount = 0;
+};
+
+// Return false if allocations are not counted on this platform, in which
+// case UsdProctestGetAllocations returns zeros.
+bool UsdProctestHasAllocationCounts();
+
+UsdProctestAllocations UsdProctestGetAllocations();
+
+// Set the size from which allocations count as large, unlimited by default.
+void UsdProctestSetLargeAllocationSize(size_t bytes);
+
+// Resident set size of the process, and its peak since the process started
+// or since the last reset, in bytes. Zero when not available.
+size_t UsdProctestGetRss();
+size_t UsdProctestGetPeakRss();
+
+// Reset the peak resident set size to the current one. Return false if the
+// platform does not support it, in which case the peak is the peak since
+// the process started.
+bool UsdProctestResetPeakRss();
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif
@@ -26,8 +26,10 @@
 PXR_NAMESPACE_OPEN_SCOPE
 
 UsdProcTestTokensType::UsdProcTestTokensType() :
+    divisions("divisions", TfToken::Immortal),
     length("length", TfToken::Immortal),
     allTokens({
+        divisions,
         length
     })
 {
@@ -62,6 +62,10 @@ PXR_NAMESPACE_OPEN_SCOPE
 /// \endcode
 struct UsdProcTestTokensType {
     USDPROCTEST_API UsdProcTestTokensType();
+    /// \brief "divisions"
+    /// 
+    /// UsdProcTestMyProcMesh
+    const TfToken divisions;
     /// \brief "length"
     /// 
     /// UsdProcTestMyProcMesh
@@ -56,6 +56,14 @@ _CreateLengthAttr(UsdProcTestMyProcMesh &self,
         UsdPythonToSdfType(defaultVal, SdfValueTypeNames->Float), writeSparsely);
 }
 
+        
+static UsdAttribute
+_CreateDivisionsAttr(UsdProcTestMyProcMesh &self,
+                                      object defaultVal, bool writeSparsely) {
+    return self.CreateDivisionsAttr(
+        UsdPythonToSdfType(defaultVal, SdfValueTypeNames->Int), writeSparsely);
+}
+
 static std::string
 _Repr(const UsdProcTestMyProcMesh &self)
 {
@@ -104,6 +112,13 @@ void wrapUsdProcTestMyProcMesh()
              &_CreateLengthAttr,
              (arg("defaultValue")=object(),
               arg("writeSparsely")=false))
+        
+        .def("GetDivisionsAttr",
+             &This::GetDivisionsAttr)
+        .def("CreateDivisionsAttr",
+             &_CreateDivisionsAttr,
+             (arg("defaultValue")=object(),
+              arg("writeSparsely")=false))
 
         .def("__repr__", ::_Repr)
     ;
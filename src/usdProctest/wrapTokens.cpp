@@ -64,5 +64,6 @@ void wrapUsdProcTestTokens()
 {
     boost::python::class_<UsdProcTestTokensType, boost::noncopyable>
         cls("Tokens", boost::python::no_init);
+    _AddToken(cls, "divisions", UsdProcTestTokens->divisions);
     _AddToken(cls, "length", UsdProcTestTokens->length);
 }
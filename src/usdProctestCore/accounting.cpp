@@ -0,0 +1,134 @@
+#include "accounting.h"
+#include "debugCodes.h"
+
+#include <pxr/base/tf/diagnostic.h>
+
+#include <chrono>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+UsdProctestGeneratedBytes _Subtract(const UsdProctestGeneratedBytes &a,
+                                    const UsdProctestGeneratedBytes &b)
+{
+  UsdProctestGeneratedBytes result;
+  result.points = a.points - b.points;
+  result.topology = a.topology - b.topology;
+  result.primvars = a.primvars - b.primvars;
+  return result;
+}
+
+void _Report(const std::string &name, const UsdProctestGeneratedBytes &resident,
+             const UsdProctestGeneratedBytes &generatedOnRead)
+{
+  TF_DEBUG(PROCTEST_INFO).Msg(
+      "%s: %zu resident bytes (points %zu, topology %zu, primvars %zu), "
+      "%zu bytes generated on read\n",
+      name.c_str(), resident.GetTotal(), resident.points, resident.topology,
+      resident.primvars, generatedOnRead.GetTotal());
+}
+
+void _ReportSample(const UsdProctestGeneratedBytesSample &sample)
+{
+  if (!TfDebug::IsEnabled(PROCTEST_INFO)) {
+    return;
+  }
+  UsdProctestReportGeneratedBytes();
+  TF_DEBUG(PROCTEST_INFO).Msg("%zu bytes generated on read since the previous report\n",
+                              sample.generatedOnReadSincePrevious.GetTotal());
+}
+
+} // namespace
+
+UsdProctestGeneratedBytes UsdProctestGetGeneratedBytes(
+    const SdfLayerHandle &layer, UsdProctestGeneratedBytes *generatedOnReadBytes)
+{
+  // The data of the layer is the most recent one with its identifier, older
+  // ones being released as the layer is reloaded.
+  const std::string identifier = layer ? layer->GetIdentifier() : std::string();
+  UsdProctestGeneratedBytes resident;
+  UsdProctestGeneratedBytes generatedOnRead;
+  bool found = false;
+  UsdProctestData::ForEachLiveData(
+      [&](const UsdProctestData &data, const std::string &layerIdentifier) {
+        if (!found && !identifier.empty() && layerIdentifier == identifier) {
+          resident = data.GetResidentBytes();
+          generatedOnRead = data.GetGeneratedOnReadBytes();
+          found = true;
+        }
+      });
+  if (generatedOnReadBytes) {
+    *generatedOnReadBytes = generatedOnRead;
+  }
+  return resident;
+}
+
+UsdProctestGeneratedBytes UsdProctestGetGlobalGeneratedBytes(
+    UsdProctestGeneratedBytes *generatedOnReadBytes)
+{
+  if (generatedOnReadBytes) {
+    *generatedOnReadBytes = UsdProctestData::GetGlobalGeneratedOnReadBytes();
+  }
+  return UsdProctestData::GetGlobalResidentBytes();
+}
+
+void UsdProctestReportGeneratedBytes()
+{
+  if (!TfDebug::IsEnabled(PROCTEST_INFO)) {
+    return;
+  }
+
+  UsdProctestData::ForEachLiveData(
+      [](const UsdProctestData &data, const std::string &layerIdentifier) {
+        if (!layerIdentifier.empty()) {
+          _Report(layerIdentifier, data.GetResidentBytes(), data.GetGeneratedOnReadBytes());
+        }
+      });
+
+  UsdProctestGeneratedBytes generatedOnRead;
+  const UsdProctestGeneratedBytes resident = UsdProctestGetGlobalGeneratedBytes(&generatedOnRead);
+  _Report("All proctest layers", resident, generatedOnRead);
+}
+
+UsdProctestGeneratedBytesReporter::UsdProctestGeneratedBytesReporter(double intervalSeconds,
+                                                                     Callback callback)
+  : _callback(callback ? std::move(callback) : Callback(_ReportSample))
+  , _previousGeneratedOnRead(UsdProctestData::GetGlobalGeneratedOnReadBytes())
+  , _thread(&UsdProctestGeneratedBytesReporter::_Run, this, intervalSeconds)
+{
+}
+
+UsdProctestGeneratedBytesReporter::~UsdProctestGeneratedBytesReporter()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _stopCondition.notify_one();
+  _thread.join();
+}
+
+void UsdProctestGeneratedBytesReporter::_Run(double intervalSeconds)
+{
+  if (intervalSeconds <= 0.0) {
+    TF_CODING_ERROR("Invalid report interval %g, reporting every second", intervalSeconds);
+    intervalSeconds = 1.0;
+  }
+  const auto interval = std::chrono::duration<double>(intervalSeconds);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_stopCondition.wait_for(lock, interval, [this]() { return _stop; })) {
+    lock.unlock();
+    UsdProctestGeneratedBytesSample sample;
+    sample.resident = UsdProctestGetGlobalGeneratedBytes(&sample.generatedOnRead);
+    sample.generatedOnReadSincePrevious =
+        _Subtract(sample.generatedOnRead, _previousGeneratedOnRead);
+    _previousGeneratedOnRead = sample.generatedOnRead;
+    _callback(sample);
+    lock.lock();
+  }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
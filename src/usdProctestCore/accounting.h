@@ -0,0 +1,78 @@
+#pragma once
+
+#include "data.h"
+
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/layer.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Queries of the memory of generated attribute values, see UsdProctestData.
+//
+// Resident bytes are a gauge: they grow as layers are generated and implicit
+// values cached, and shrink as layers are released and cached values
+// evicted. Generated on read bytes are cumulative, the total allocated by
+// implicit values each time they were generated; their growth between two
+// samples gives the rate of regeneration.
+
+// Return the bytes of generated attribute values resident in layer, zero
+// if it is not a proctest layer, and the bytes allocated so far by reading
+// its implicit values in generatedOnReadBytes when given.
+UsdProctestGeneratedBytes UsdProctestGetGeneratedBytes(
+    const SdfLayerHandle &layer, UsdProctestGeneratedBytes *generatedOnReadBytes = nullptr);
+
+// The same, summed over all live proctest layers.
+UsdProctestGeneratedBytes UsdProctestGetGlobalGeneratedBytes(
+    UsdProctestGeneratedBytes *generatedOnReadBytes = nullptr);
+
+// Report the generated bytes of each live proctest layer and their total
+// through the PROCTEST_INFO debug flag. Layers are enumerated through the
+// registry of live UsdProctestData, never through SdfLayer, so that this
+// is safe from any thread.
+void UsdProctestReportGeneratedBytes();
+
+// Global generated bytes at one point in time.
+struct UsdProctestGeneratedBytesSample {
+  UsdProctestGeneratedBytes resident;
+  UsdProctestGeneratedBytes generatedOnRead;
+  // Bytes generated on read since the previous sample.
+  UsdProctestGeneratedBytes generatedOnReadSincePrevious;
+};
+
+// Sample the global generated bytes every intervalSeconds, which must be
+// positive, from a background thread as long as the reporter is alive.
+//
+// Each sample is passed to the callback, by default reported through the
+// PROCTEST_INFO debug flag along with the bytes of each proctest layer. The
+// callback runs on the reporter thread.
+class UsdProctestGeneratedBytesReporter {
+public:
+  using Callback = std::function<void(const UsdProctestGeneratedBytesSample &)>;
+
+  explicit UsdProctestGeneratedBytesReporter(double intervalSeconds,
+                                             Callback callback = Callback());
+  ~UsdProctestGeneratedBytesReporter();
+
+  UsdProctestGeneratedBytesReporter(const UsdProctestGeneratedBytesReporter &) = delete;
+  UsdProctestGeneratedBytesReporter &operator=(const UsdProctestGeneratedBytesReporter &) =
+      delete;
+
+private:
+  void _Run(double intervalSeconds);
+
+  Callback _callback;
+  // Global generated on read bytes of the previous sample, or of the
+  // creation of the reporter.
+  UsdProctestGeneratedBytes _previousGeneratedOnRead;
+  std::mutex _mutex;
+  std::condition_variable _stopCondition;
+  bool _stop = false;
+  std::thread _thread;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,257 @@
+#include "bake.h"
+
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/vt/dictionary.h>
+#include <pxr/usd/sdf/attributeSpec.h>
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/sdf/primSpec.h>
+#include <pxr/usd/sdf/reference.h>
+#include <pxr/usd/sdf/types.h>
+#include <pxr/usd/usdGeom/tokens.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/* clang-format off */
+TF_DEFINE_PRIVATE_TOKENS(
+    _tokens,
+    ((SideLength, "proctest:sideLength"))
+    ((Divisions, "proctest:divisions"))
+    ((GeneratorVersion, "proctest:generatorVersion"))
+    ((ChunkCount, "proctest:chunkCount"))
+    ((ParamsHash, "proctest:paramsHash"))
+    (Root)
+    (Chunk)
+    (Mesh)
+    (Xform)
+);
+/* clang-format on */
+
+// Return a hash of the parameters a bake depends on, formatted to name its
+// chunk files.
+static std::string
+_GetParamsHash(const UsdProctestCubeParams& params)
+{
+    uint64_t hash = ArchHash64(reinterpret_cast<const char*>(&params.sideLength),
+                               sizeof(params.sideLength));
+    hash = ArchHash64(reinterpret_cast<const char*>(&params.divisions),
+                      sizeof(params.divisions), hash);
+    return TfStringPrintf("%016llx", static_cast<unsigned long long>(hash));
+}
+
+// The chunk files of a bake are named after its parameters, so that bakes
+// of different parameters at the same path do not overwrite the chunks of
+// one another, which layers opened from the other bake may still
+// reference.
+static std::string
+_GetChunkPath(const std::string& filePath, const std::string& paramsHash, size_t chunk)
+{
+    return TfStringPrintf("%s.%s.chunk%zu.usdc", TfStringGetBeforeSuffix(filePath).c_str(),
+                          paramsHash.c_str(), chunk);
+}
+
+static bool
+_CreateAttribute(const SdfPrimSpecHandle& prim,
+                 const TfToken& name,
+                 const SdfValueTypeName& typeName,
+                 VtValue&& value,
+                 SdfVariability variability = SdfVariabilityVarying)
+{
+    SdfAttributeSpecHandle attr =
+        SdfAttributeSpec::New(prim, name, typeName, variability);
+    if (!attr) {
+        return false;
+    }
+    attr->SetDefaultValue(value);
+    return true;
+}
+
+// Export layer to filePath, and reload any opened layer at this path so
+// that it does not keep serving a previous bake.
+static bool
+_ExportLayer(const SdfLayerRefPtr& layer, const std::string& filePath)
+{
+    if (!layer->Export(filePath)) {
+        return false;
+    }
+    if (SdfLayerHandle opened = SdfLayer::Find(filePath)) {
+        opened->Reload(/* force = */ true);
+    }
+    return true;
+}
+
+static bool
+_BakeChunk(const UsdProctestCubeParams& params,
+           const UsdProctestCubeRange& range,
+           const std::string& chunkPath)
+{
+    SdfLayerRefPtr layer = SdfLayer::CreateAnonymous(".usdc");
+    SdfPrimSpecHandle mesh = SdfPrimSpec::New(
+        layer, _tokens->Chunk.GetString(), SdfSpecifierDef, _tokens->Mesh.GetString());
+    if (!mesh) {
+        return false;
+    }
+    layer->SetDefaultPrim(mesh->GetNameToken());
+
+    // The chunk layer, and the arrays it holds, are released on return, so
+    // that at most one chunk worth of geometry is alive at any time.
+
+    return _CreateAttribute(
+               mesh, UsdGeomTokens->faceVertexCounts, SdfValueTypeNames->IntArray,
+               VtValue::Take(UsdProctestGenerateCubeFaceVertexCounts(params, range))) &&
+           _CreateAttribute(
+               mesh, UsdGeomTokens->faceVertexIndices, SdfValueTypeNames->IntArray,
+               VtValue::Take(UsdProctestGenerateCubeFaceVertexIndices(params, range))) &&
+           _CreateAttribute(
+               mesh, UsdGeomTokens->points, SdfValueTypeNames->Point3fArray,
+               VtValue::Take(UsdProctestGenerateCubePoints(params, range))) &&
+           _CreateAttribute(
+               mesh, UsdGeomTokens->subdivisionScheme, SdfValueTypeNames->Token,
+               VtValue(UsdGeomTokens->none), SdfVariabilityUniform) &&
+           _ExportLayer(layer, chunkPath);
+}
+
+bool
+UsdProctestBakeCube(const UsdProctestCubeParams& params,
+                    const std::string& filePath,
+                    size_t maxChunkFaces)
+{
+    SdfLayerRefPtr layer = SdfLayer::CreateAnonymous(".usdc");
+    SdfPrimSpecHandle root = SdfPrimSpec::New(
+        layer, _tokens->Root.GetString(), SdfSpecifierDef, _tokens->Xform.GetString());
+    if (!TF_VERIFY(root)) {
+        return false;
+    }
+    layer->SetDefaultPrim(root->GetNameToken());
+
+    const std::vector<UsdProctestCubeRange> ranges =
+        UsdProctestSplitCube(params, maxChunkFaces);
+    const std::string paramsHash = _GetParamsHash(params);
+
+    VtDictionary customLayerData;
+    customLayerData[_tokens->SideLength.GetString()] = VtValue(params.sideLength);
+    customLayerData[_tokens->Divisions.GetString()] = VtValue(params.divisions);
+    customLayerData[_tokens->GeneratorVersion.GetString()] =
+        VtValue(UsdProctestGeneratorVersion);
+    customLayerData[_tokens->ChunkCount.GetString()] =
+        VtValue(static_cast<int>(ranges.size()));
+    customLayerData[_tokens->ParamsHash.GetString()] = VtValue(paramsHash);
+    layer->SetCustomLayerData(customLayerData);
+    for (size_t chunk = 0; chunk < ranges.size(); ++chunk) {
+        const std::string chunkPath = _GetChunkPath(filePath, paramsHash, chunk);
+        if (!_BakeChunk(params, ranges[chunk], chunkPath)) {
+            TF_RUNTIME_ERROR("Cannot bake chunk '%s'", chunkPath.c_str());
+            return false;
+        }
+
+        SdfPrimSpecHandle chunkPrim = SdfPrimSpec::New(
+            root, TfStringPrintf("Chunk_%zu", chunk), SdfSpecifierDef);
+        if (!TF_VERIFY(chunkPrim)) {
+            return false;
+        }
+        chunkPrim->GetReferenceList().Prepend(
+            SdfReference("./" + TfGetBaseName(chunkPath)));
+    }
+
+    // The root is written last, so that an interrupted bake is never
+    // considered up to date.
+
+    if (!_ExportLayer(layer, filePath)) {
+        TF_RUNTIME_ERROR("Cannot write bake '%s'", filePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool
+UsdProctestIsBakeUpToDate(const UsdProctestCubeParams& params,
+                          const std::string& filePath)
+{
+    if (!TfIsFile(filePath)) {
+        return false;
+    }
+
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(filePath);
+    if (!layer) {
+        return false;
+    }
+
+    const VtDictionary customLayerData = layer->GetCustomLayerData();
+    const auto isInt = [&customLayerData](const TfToken& key, int value) {
+        return VtDictionaryIsHolding<int>(customLayerData, key.GetString()) &&
+               VtDictionaryGet<int>(customLayerData, key.GetString()) == value;
+    };
+    const std::string paramsHash = _GetParamsHash(params);
+    if (!VtDictionaryIsHolding<float>(customLayerData, _tokens->SideLength.GetString()) ||
+        VtDictionaryGet<float>(customLayerData, _tokens->SideLength.GetString()) !=
+            params.sideLength ||
+        !isInt(_tokens->Divisions, params.divisions) ||
+        !isInt(_tokens->GeneratorVersion, UsdProctestGeneratorVersion) ||
+        !VtDictionaryIsHolding<int>(customLayerData, _tokens->ChunkCount.GetString()) ||
+        !VtDictionaryIsHolding<std::string>(customLayerData,
+                                            _tokens->ParamsHash.GetString()) ||
+        VtDictionaryGet<std::string>(customLayerData, _tokens->ParamsHash.GetString()) !=
+            paramsHash) {
+        return false;
+    }
+
+    // A partially deleted bake is not up to date, the chunks being only
+    // referenced by the root.
+
+    const int chunkCount =
+        VtDictionaryGet<int>(customLayerData, _tokens->ChunkCount.GetString());
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        if (!TfIsFile(_GetChunkPath(filePath, paramsHash, static_cast<size_t>(chunk)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string
+UsdProctestGetBakeChunkPath(const UsdProctestCubeParams& params,
+                            const std::string& filePath,
+                            size_t chunk)
+{
+    return _GetChunkPath(filePath, _GetParamsHash(params), chunk);
+}
+
+uint64_t
+UsdProctestHashBakeFiles(const std::string& filePath, uint64_t seed)
+{
+    const auto hashFile = [](const std::string& path, uint64_t hash) {
+        double modificationTime = 0.0;
+        ArchGetModificationTime(path.c_str(), &modificationTime);
+        const int64_t size = ArchGetFileLength(path.c_str());
+        hash = ArchHash64(path.c_str(), path.size(), hash);
+        hash = ArchHash64(reinterpret_cast<const char*>(&modificationTime),
+                          sizeof(modificationTime), hash);
+        return ArchHash64(reinterpret_cast<const char*>(&size), sizeof(size), hash);
+    };
+
+    uint64_t hash = hashFile(filePath, seed);
+
+    SdfLayerRefPtr layer = SdfLayer::FindOrOpen(filePath);
+    const VtDictionary customLayerData =
+        layer ? layer->GetCustomLayerData() : VtDictionary();
+    if (VtDictionaryIsHolding<int>(customLayerData, _tokens->ChunkCount.GetString()) &&
+        VtDictionaryIsHolding<std::string>(customLayerData,
+                                           _tokens->ParamsHash.GetString())) {
+        const int chunkCount =
+            VtDictionaryGet<int>(customLayerData, _tokens->ChunkCount.GetString());
+        const std::string paramsHash =
+            VtDictionaryGet<std::string>(customLayerData, _tokens->ParamsHash.GetString());
+        for (int chunk = 0; chunk < chunkCount; ++chunk) {
+            hash = hashFile(_GetChunkPath(filePath, paramsHash, static_cast<size_t>(chunk)),
+                            hash);
+        }
+    }
+    return hash;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "generator.h"
+
+#include <pxr/pxr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Default number of faces written per baked chunk.
+constexpr size_t UsdProctestDefaultBakeChunkFaces = 1 << 20;
+
+// Bake the cube described by params to the crate file at filePath.
+//
+// The cube is generated one range of at most maxChunkFaces faces at a time,
+// each range being written to its own mesh in a sibling crate file and
+// released before the next one is generated, so that peak memory is bounded
+// by the chunk size rather than by the size of the cube. The file at
+// filePath holds a /Root prim referencing every chunk. Chunk files are
+// named after params, see UsdProctestGetBakeChunkPath, so that bakes of
+// different parameters to the same filePath keep their own chunks.
+bool UsdProctestBakeCube(const UsdProctestCubeParams &params,
+                         const std::string &filePath,
+                         size_t maxChunkFaces = UsdProctestDefaultBakeChunkFaces);
+
+// Return the path of the chunk file of index chunk of the bake of the cube
+// described by params to filePath.
+std::string UsdProctestGetBakeChunkPath(const UsdProctestCubeParams &params,
+                                        const std::string &filePath, size_t chunk);
+
+// Return true if filePath holds a bake of the cube described by params, made
+// by the current version of the generator, and all its chunk files exist.
+bool UsdProctestIsBakeUpToDate(const UsdProctestCubeParams &params,
+                               const std::string &filePath);
+
+// Return a hash, combined with seed, of the paths, sizes and modification
+// times of the files of the bake at filePath, which changes whenever the
+// bake is rewritten.
+uint64_t UsdProctestHashBakeFiles(const std::string &filePath, uint64_t seed = 0);
+
+PXR_NAMESPACE_CLOSE_SCOPE
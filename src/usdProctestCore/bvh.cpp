@@ -0,0 +1,291 @@
+#include "bvh.h"
+
+#include <pxr/base/gf/bbox3d.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/usd/sdf/types.h>
+#include <pxr/usd/usd/attribute.h>
+
+#include <algorithm>
+#include <utility>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PUBLIC_TOKENS(UsdProctestBvhTokens, USD_PROCTEST_BVH_TOKENS);
+
+namespace {
+
+// Leaves hold a single instance, so that queries are exact without storing
+// the bounds of each instance next to the hierarchy.
+const size_t maxLeafItems = 1;
+
+struct _Builder {
+  explicit _Builder(const std::vector<GfRange3f> &instanceBounds)
+    : bounds(instanceBounds)
+    , centroids(instanceBounds.size())
+    , items(instanceBounds.size())
+  {
+    for (size_t i = 0; i < bounds.size(); ++i) {
+      centroids[i] = bounds[i].GetMidpoint();
+      items[i] = static_cast<int>(i);
+    }
+  }
+
+  // Build the subtree over items [begin, end) and return its root node.
+  size_t Build(size_t begin, size_t end)
+  {
+    GfRange3f range;
+    GfRange3f centroidRange;
+    for (size_t i = begin; i < end; ++i) {
+      range.UnionWith(bounds[items[i]]);
+      centroidRange.UnionWith(centroids[items[i]]);
+    }
+
+    const size_t node = nodes.size() / 2;
+    const GfVec3f &min = range.GetMin();
+    const GfVec3f &max = range.GetMax();
+    nodeBounds.insert(nodeBounds.end(), {min[0], min[1], min[2], max[0], max[1], max[2]});
+    nodes.insert(nodes.end(), {static_cast<int>(begin), static_cast<int>(end - begin)});
+
+    if (end - begin <= maxLeafItems) {
+      return node;
+    }
+
+    // Median split along the largest extent of the centroids. Ties are
+    // broken by instance index, so the hierarchy only depends on its input.
+
+    const GfVec3f size = centroidRange.GetSize();
+    const size_t axis = size[0] >= size[1] ? (size[0] >= size[2] ? 0 : 2)
+                                           : (size[1] >= size[2] ? 1 : 2);
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                     [this, axis](int a, int b) {
+                       const float ca = centroids[a][axis];
+                       const float cb = centroids[b][axis];
+                       return ca < cb || (ca == cb && a < b);
+                     });
+
+    Build(begin, mid);
+    const size_t second = Build(mid, end);
+    nodes[2 * node] = static_cast<int>(second);
+    nodes[2 * node + 1] = 0;
+    return node;
+  }
+
+  const std::vector<GfRange3f> &bounds;
+  std::vector<GfVec3f> centroids;
+  std::vector<int> items;
+  std::vector<float> nodeBounds;
+  std::vector<int> nodes;
+};
+
+template <class T>
+VtArray<T> _ToVtArray(const std::vector<T> &values)
+{
+  return VtArray<T>(values.begin(), values.end());
+}
+
+template <class Query, class Fn>
+std::vector<std::vector<int>> _QueryBatch(const std::vector<Query> &queries, Fn &&fn)
+{
+  std::vector<std::vector<int>> results(queries.size());
+  WorkParallelForN(queries.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      results[i] = fn(queries[i]);
+    }
+  });
+  return results;
+}
+
+GfRange3d _ToRange3d(const GfRange3f &range)
+{
+  return GfRange3d(GfVec3d(range.GetMin()), GfVec3d(range.GetMax()));
+}
+
+} // namespace
+
+UsdProctestBvh UsdProctestBvh::Build(const std::vector<GfRange3f> &instanceBounds)
+{
+  UsdProctestBvh bvh;
+  if (instanceBounds.empty()) {
+    return bvh;
+  }
+
+  _Builder builder(instanceBounds);
+  builder.nodeBounds.reserve(6 * (2 * instanceBounds.size() - 1));
+  builder.nodes.reserve(2 * (2 * instanceBounds.size() - 1));
+  builder.Build(0, instanceBounds.size());
+
+  bvh._bounds = _ToVtArray(builder.nodeBounds);
+  bvh._nodes = _ToVtArray(builder.nodes);
+  bvh._items = _ToVtArray(builder.items);
+  return bvh;
+}
+
+bool UsdProctestBvh::Read(const UsdPrim &prim, UsdProctestBvh *bvh)
+{
+  UsdProctestBvh result;
+  if (!prim.GetAttribute(UsdProctestBvhTokens->Bounds).Get(&result._bounds) ||
+      !prim.GetAttribute(UsdProctestBvhTokens->Nodes).Get(&result._nodes) ||
+      !prim.GetAttribute(UsdProctestBvhTokens->Items).Get(&result._items)) {
+    return false;
+  }
+
+  if (!result._IsValid()) {
+    TF_WARN("Invalid bounding volume hierarchy on <%s>", prim.GetPath().GetText());
+    return false;
+  }
+
+  *bvh = std::move(result);
+  return true;
+}
+
+bool UsdProctestBvh::Write(const UsdPrim &prim) const
+{
+  const auto writeAttr = [&prim](const TfToken &name, const SdfValueTypeName &typeName,
+                                 const VtValue &value) {
+    UsdAttribute attr =
+        prim.CreateAttribute(name, typeName, /* custom = */ true, SdfVariabilityUniform);
+    return attr && attr.Set(value);
+  };
+  return writeAttr(UsdProctestBvhTokens->Bounds, SdfValueTypeNames->FloatArray,
+                   VtValue(_bounds)) &&
+         writeAttr(UsdProctestBvhTokens->Nodes, SdfValueTypeNames->IntArray,
+                   VtValue(_nodes)) &&
+         writeAttr(UsdProctestBvhTokens->Items, SdfValueTypeNames->IntArray,
+                   VtValue(_items));
+}
+
+bool UsdProctestBvh::_IsValid() const
+{
+  if (_nodes.size() % 2 != 0 || _bounds.size() != 3 * _nodes.size()) {
+    return false;
+  }
+
+  // The children of an inner node follow it, its first child immediately,
+  // so that traversals also always terminate.
+
+  const size_t nodeCount = _nodes.size() / 2;
+  for (size_t node = 0; node < nodeCount; ++node) {
+    const int first = _nodes[2 * node];
+    const int count = _nodes[2 * node + 1];
+    if (first < 0 || count < 0) {
+      return false;
+    }
+    if (count > 0) {
+      if (static_cast<size_t>(first) + static_cast<size_t>(count) > _items.size()) {
+        return false;
+      }
+    } else if (static_cast<size_t>(first) <= node + 1 ||
+               static_cast<size_t>(first) >= nodeCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+GfRange3f UsdProctestBvh::_GetNodeBounds(size_t node) const
+{
+  const float *b = _bounds.cdata() + 6 * node;
+  return GfRange3f(GfVec3f(b[0], b[1], b[2]), GfVec3f(b[3], b[4], b[5]));
+}
+
+template <class Overlaps, class Visit>
+void UsdProctestBvh::_Traverse(Overlaps &&overlaps, Visit &&visit) const
+{
+  if (_nodes.empty()) {
+    return;
+  }
+
+  std::vector<size_t> stack(1, 0);
+  while (!stack.empty()) {
+    const size_t node = stack.back();
+    stack.pop_back();
+
+    const GfRange3f bounds = _GetNodeBounds(node);
+    if (!overlaps(bounds)) {
+      continue;
+    }
+
+    const int first = _nodes[2 * node];
+    const int count = _nodes[2 * node + 1];
+    if (count > 0) {
+      for (int i = first; i < first + count; ++i) {
+        visit(_items[i], bounds);
+      }
+    } else {
+      stack.push_back(static_cast<size_t>(first));
+      stack.push_back(node + 1);
+    }
+  }
+}
+
+std::vector<int> UsdProctestBvh::QueryBox(const GfRange3f &box) const
+{
+  std::vector<int> result;
+  _Traverse(
+      [&box](const GfRange3f &bounds) {
+        return !GfRange3f::GetIntersection(box, bounds).IsEmpty();
+      },
+      [&result](int item, const GfRange3f &) { result.push_back(item); });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<int> UsdProctestBvh::QueryFrustum(const GfFrustum &frustum) const
+{
+  // GfFrustum lazily caches its planes, use a copy so that concurrent
+  // queries never share one.
+  const GfFrustum queryFrustum = frustum;
+
+  std::vector<int> result;
+  _Traverse(
+      [&queryFrustum](const GfRange3f &bounds) {
+        return queryFrustum.Intersects(GfBBox3d(_ToRange3d(bounds)));
+      },
+      [&result](int item, const GfRange3f &) { result.push_back(item); });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<int> UsdProctestBvh::QueryRay(const GfRay &ray) const
+{
+  std::vector<std::pair<double, int>> hits;
+  _Traverse(
+      [&ray](const GfRange3f &bounds) {
+        return ray.Intersect(_ToRange3d(bounds));
+      },
+      [&ray, &hits](int item, const GfRange3f &bounds) {
+        double enterDistance = 0.0;
+        ray.Intersect(_ToRange3d(bounds), &enterDistance);
+        hits.emplace_back(enterDistance, item);
+      });
+  std::sort(hits.begin(), hits.end());
+
+  std::vector<int> result;
+  result.reserve(hits.size());
+  for (const auto &hit : hits) {
+    result.push_back(hit.second);
+  }
+  return result;
+}
+
+std::vector<std::vector<int>> UsdProctestBvh::QueryBoxes(
+    const std::vector<GfRange3f> &boxes) const
+{
+  return _QueryBatch(boxes, [this](const GfRange3f &box) { return QueryBox(box); });
+}
+
+std::vector<std::vector<int>> UsdProctestBvh::QueryFrustums(
+    const std::vector<GfFrustum> &frustums) const
+{
+  return _QueryBatch(frustums,
+                     [this](const GfFrustum &frustum) { return QueryFrustum(frustum); });
+}
+
+std::vector<std::vector<int>> UsdProctestBvh::QueryRays(const std::vector<GfRay> &rays) const
+{
+  return _QueryBatch(rays, [this](const GfRay &ray) { return QueryRay(ray); });
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <pxr/base/gf/frustum.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/ray.h>
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/prim.h>
+
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/* clang-format off */
+#define USD_PROCTEST_BVH_TOKENS                     \
+    ((Bounds, "proctest:bvh:bounds"))               \
+    ((Nodes, "proctest:bvh:nodes"))                 \
+    ((Items, "proctest:bvh:items"))
+/* clang-format on */
+
+TF_DECLARE_PUBLIC_TOKENS(UsdProctestBvhTokens, USD_PROCTEST_BVH_TOKENS);
+
+// Bounding volume hierarchy over the bounds of the instances of a merged
+// layout, answering which instances a box, a frustum or a ray touch without
+// visiting every instance.
+//
+// The hierarchy is stored as flat arrays, so that it can be persisted as
+// attributes of the generated prim and read back without rebuilding:
+//  - bounds: min and max corners of each node, 6 floats per node,
+//  - nodes: 2 ints per node, the first item and item count of leaves, or
+//    the index of the second child and 0 for inner nodes whose first child
+//    immediately follows them,
+//  - items: the instance indices, ordered so that each leaf references a
+//    contiguous range.
+//
+// Queries are const and can run concurrently, the batched variants run
+// their queries in parallel. Results are sorted by instance index, except
+// for rays sorted by entry distance.
+class UsdProctestBvh {
+public:
+  UsdProctestBvh() = default;
+
+  // Build the hierarchy over the bounds of each instance.
+  static UsdProctestBvh Build(const std::vector<GfRange3f> &instanceBounds);
+
+  // Read the hierarchy from the attributes of prim. Return false, with a
+  // warning, if they do not describe a valid hierarchy.
+  static bool Read(const UsdPrim &prim, UsdProctestBvh *bvh);
+
+  // Author the hierarchy as attributes of prim.
+  bool Write(const UsdPrim &prim) const;
+
+  bool IsEmpty() const { return _nodes.empty(); }
+
+  std::vector<int> QueryBox(const GfRange3f &box) const;
+  std::vector<int> QueryFrustum(const GfFrustum &frustum) const;
+  std::vector<int> QueryRay(const GfRay &ray) const;
+
+  std::vector<std::vector<int>> QueryBoxes(const std::vector<GfRange3f> &boxes) const;
+  std::vector<std::vector<int>> QueryFrustums(const std::vector<GfFrustum> &frustums) const;
+  std::vector<std::vector<int>> QueryRays(const std::vector<GfRay> &rays) const;
+
+private:
+  // Return true if the arrays describe a hierarchy whose child and item
+  // ranges are all in bounds, which traversals rely on.
+  bool _IsValid() const;
+
+  GfRange3f _GetNodeBounds(size_t node) const;
+
+  // Call visit(item, bounds) for the items of the leaves whose bounds, and
+  // those of their ancestors, satisfy overlaps.
+  template <class Overlaps, class Visit>
+  void _Traverse(Overlaps &&overlaps, Visit &&visit) const;
+
+  VtFloatArray _bounds;
+  VtIntArray _nodes;
+  VtIntArray _items;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pxr/base/work/loops.h>
+#include <pxr/pxr.h>
+
+#include <algorithm>
+#include <cstddef>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Number of elements processed by a single parallel task, shared by the
+// generator and the encoding of points. Chunks are fixed rather than left
+// to the scheduler so that per-chunk results, reduced in chunk order, do not
+// depend on the number of threads.
+constexpr size_t UsdProctestChunkSize = 16384;
+
+inline size_t UsdProctestGetChunkCount(size_t count)
+{
+  return (count + UsdProctestChunkSize - 1) / UsdProctestChunkSize;
+}
+
+// Call fn(chunk, begin, end) in parallel over the chunks of [0, count).
+template <class Fn>
+void UsdProctestForEachChunk(size_t count, Fn &&fn)
+{
+  WorkParallelForN(UsdProctestGetChunkCount(count),
+                   [count, &fn](size_t chunkBegin, size_t chunkEnd) {
+    for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk) {
+      const size_t begin = chunk * UsdProctestChunkSize;
+      fn(chunk, begin, std::min(begin + UsdProctestChunkSize, count));
+    }
+  });
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
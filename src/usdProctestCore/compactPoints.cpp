@@ -0,0 +1,151 @@
+#include "compactPoints.h"
+
+#include "chunks.h"
+
+#include <pxr/base/gf/vec3h.h>
+#include <pxr/base/tf/diagnostic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PUBLIC_TOKENS(UsdProctestPointsPrecisionTokens, USD_PROCTEST_POINTS_PRECISION_TOKENS);
+
+namespace {
+
+const float maxQuantizedValue = static_cast<float>(std::numeric_limits<uint16_t>::max());
+
+// Largest finite half, larger components would be encoded as infinities.
+const float maxHalfValue = 65504.0f;
+
+GfRange3f _ComputeBounds(const VtVec3fArray &points)
+{
+  std::vector<GfRange3f> chunkBounds(UsdProctestGetChunkCount(points.size()));
+  UsdProctestForEachChunk(points.size(), [&](size_t chunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      chunkBounds[chunk].UnionWith(points[i]);
+    }
+  });
+
+  GfRange3f bounds;
+  for (const GfRange3f &range : chunkBounds) {
+    bounds.UnionWith(range);
+  }
+  return bounds;
+}
+
+} // namespace
+
+UsdProctestCompactPoints UsdProctestCompactPoints::Encode(const VtVec3fArray &points,
+                                                          const TfToken &precision)
+{
+  UsdProctestCompactPoints result;
+  result._size = points.size();
+
+  if (precision == UsdProctestPointsPrecisionTokens->Half) {
+    const GfRange3f bounds = _ComputeBounds(points);
+    for (size_t axis = 0; axis < 3; ++axis) {
+      if (std::max(std::abs(bounds.GetMin()[axis]), std::abs(bounds.GetMax()[axis])) >
+          maxHalfValue) {
+        TF_WARN("Points exceed the range of half floats, storing them as floats");
+        result._floatPoints = points;
+        return result;
+      }
+    }
+
+    result._halfPoints.resize(points.size(), [&](GfVec3h *b, GfVec3h *e) {
+      UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          b[i] = GfVec3h(points[i]);
+        }
+      });
+    });
+  } else if (precision == UsdProctestPointsPrecisionTokens->Quantized) {
+    result._bounds = _ComputeBounds(points);
+    const GfVec3f min = result._bounds.GetMin();
+    const GfVec3f size = result._bounds.GetSize();
+    GfVec3f scale;
+    for (size_t axis = 0; axis < 3; ++axis) {
+      scale[axis] = size[axis] > 0.0f ? maxQuantizedValue / size[axis] : 0.0f;
+    }
+
+    auto quantizedPoints = std::make_shared<std::vector<uint16_t>>(3 * points.size());
+    uint16_t *q = quantizedPoints->data();
+    UsdProctestForEachChunk(points.size(), [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+          q[3 * i + axis] = static_cast<uint16_t>(
+              std::lround((points[i][axis] - min[axis]) * scale[axis]));
+        }
+      }
+    });
+    result._quantizedPoints = std::move(quantizedPoints);
+  } else {
+    TF_CODING_ERROR("Unsupported points precision '%s'", precision.GetText());
+    result._size = 0;
+    return result;
+  }
+
+  // Measure the error of the decoded points. Chunks keep their own maximum
+  // so that the result does not depend on scheduling.
+
+  const VtVec3fArray decoded = result.Decode();
+  std::vector<float> chunkErrors(UsdProctestGetChunkCount(points.size()), 0.0f);
+  UsdProctestForEachChunk(points.size(), [&](size_t chunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      chunkErrors[chunk] = std::max(chunkErrors[chunk], (decoded[i] - points[i]).GetLength());
+    }
+  });
+  for (float error : chunkErrors) {
+    result._maxError = std::max(result._maxError, error);
+  }
+
+  return result;
+}
+
+VtVec3fArray UsdProctestCompactPoints::Decode() const
+{
+  if (!_floatPoints.empty()) {
+    return _floatPoints;
+  }
+
+  VtVec3fArray points;
+  if (!_halfPoints.empty()) {
+    points.resize(_size, [this](GfVec3f *b, GfVec3f *e) {
+      UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          b[i] = GfVec3f(_halfPoints[i]);
+        }
+      });
+    });
+  } else if (_quantizedPoints) {
+    const GfVec3f min = _bounds.GetMin();
+    const GfVec3f step = _bounds.GetSize() / maxQuantizedValue;
+    const uint16_t *q = _quantizedPoints->data();
+    points.resize(_size, [&](GfVec3f *b, GfVec3f *e) {
+      UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          b[i] = GfVec3f(min[0] + q[3 * i] * step[0],
+                         min[1] + q[3 * i + 1] * step[1],
+                         min[2] + q[3 * i + 2] * step[2]);
+        }
+      });
+    });
+  }
+  return points;
+}
+
+size_t UsdProctestCompactPoints::GetSizeInBytes() const
+{
+  if (_quantizedPoints) {
+    return _quantizedPoints->size() * sizeof(uint16_t) + sizeof(_bounds);
+  }
+  if (!_floatPoints.empty()) {
+    return GetFullPrecisionSizeInBytes();
+  }
+  return _halfPoints.size() * sizeof(GfVec3h);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
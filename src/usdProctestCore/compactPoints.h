@@ -0,0 +1,68 @@
+#pragma once
+
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/* clang-format off */
+#define USD_PROCTEST_POINTS_PRECISION_TOKENS        \
+    ((Float, "float"))                              \
+    ((Half, "half"))                                \
+    ((Quantized, "quantized"))
+/* clang-format on */
+
+TF_DECLARE_PUBLIC_TOKENS(UsdProctestPointsPrecisionTokens, USD_PROCTEST_POINTS_PRECISION_TOKENS);
+
+// Points stored at a reduced precision and decoded to full precision when
+// read:
+//  - half: each component is a half float, 6 bytes per point,
+//  - quantized: each component is a 16 bit integer mapped to the bounds of
+//    the points, 6 bytes per point with an error uniform over the bounds.
+//
+// Points beyond the range of half floats are kept at full precision rather
+// than encoded as infinities.
+//
+// Encoding and decoding are parallel passes over fixed-size chunks.
+class UsdProctestCompactPoints {
+public:
+  // Encode points with precision, one of UsdProctestPointsPrecisionTokens
+  // other than float. Warn and keep the points as floats if precision is
+  // half and they do not fit.
+  static UsdProctestCompactPoints Encode(const VtVec3fArray &points,
+                                         const TfToken &precision);
+
+  VtVec3fArray Decode() const;
+
+  size_t GetSize() const { return _size; }
+
+  // Return true if the points are stored at a reduced precision, false if
+  // they were kept as floats.
+  bool IsEncoded() const { return _floatPoints.empty(); }
+
+  // Memory used by the encoded points, and by the same points at full
+  // precision.
+  size_t GetSizeInBytes() const;
+  size_t GetFullPrecisionSizeInBytes() const { return _size * sizeof(GfVec3f); }
+
+  // Largest distance between a point and its decoded value.
+  float GetMaxError() const { return _maxError; }
+
+private:
+  VtVec3fArray _floatPoints;
+  VtVec3hArray _halfPoints;
+  std::shared_ptr<const std::vector<uint16_t>> _quantizedPoints;
+  GfRange3f _bounds;
+  size_t _size = 0;
+  float _maxError = 0.0f;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
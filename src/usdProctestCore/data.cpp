@@ -0,0 +1,481 @@
+#include "data.h"
+
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/vec3h.h>
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/type.h>
+#include <pxr/usd/sdf/schema.h>
+#include <pxr/usd/usdGeom/tokens.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_ENV_SETTING(PROCTEST_IMPLICIT_CACHE_MB, 64,
+                      "Megabytes of generated implicit values cached over all proctest layers.");
+
+namespace {
+
+enum _Kind { _KindPoints, _KindTopology, _KindPrimvars, _KindCount };
+
+std::atomic<size_t> _globalResidentBytes[_KindCount] = {};
+std::atomic<size_t> _globalGeneratedOnReadBytes[_KindCount] = {};
+// Guarded by the cache mutex.
+size_t _globalCachedBytes = 0;
+std::atomic<size_t> _createdCount(0);
+std::atomic<size_t> _liveCount(0);
+
+// Registry of the live data, so that they can be enumerated without going
+// through layers that other threads may be releasing.
+std::mutex &_GetLiveDataMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<size_t, const UsdProctestData *> &_GetLiveData()
+{
+  static std::map<size_t, const UsdProctestData *> liveData;
+  return liveData;
+}
+
+std::atomic<size_t> &_GetCacheBudget()
+{
+  static std::atomic<size_t> budget(
+      static_cast<size_t>(std::max(0, TfGetEnvSetting(PROCTEST_IMPLICIT_CACHE_MB))) << 20);
+  return budget;
+}
+
+_Kind _GetKind(const SdfPath &attrPath)
+{
+  const TfToken &name = attrPath.GetNameToken();
+  if (name == UsdGeomTokens->points || name == UsdGeomTokens->velocities) {
+    return _KindPoints;
+  }
+  if (name == UsdGeomTokens->faceVertexCounts || name == UsdGeomTokens->faceVertexIndices ||
+      name == UsdGeomTokens->indices) {
+    return _KindTopology;
+  }
+  return _KindPrimvars;
+}
+
+template <class T>
+bool _GetArrayBytes(const VtValue &value, size_t *bytes)
+{
+  if (!value.IsHolding<VtArray<T>>()) {
+    return false;
+  }
+  *bytes = value.UncheckedGet<VtArray<T>>().size() * sizeof(T);
+  return true;
+}
+
+// Return the bytes of the elements of the array held by value, 0 if it does
+// not hold an array of one of the types generated by proctest.
+size_t _GetValueBytes(const VtValue &value)
+{
+  size_t bytes = 0;
+  (void)(_GetArrayBytes<GfVec3f>(value, &bytes) || _GetArrayBytes<int>(value, &bytes) ||
+         _GetArrayBytes<float>(value, &bytes) || _GetArrayBytes<GfVec3h>(value, &bytes) ||
+         _GetArrayBytes<GfVec2f>(value, &bytes));
+  return bytes;
+}
+
+UsdProctestGeneratedBytes _Load(const std::atomic<size_t> (&counts)[_KindCount])
+{
+  UsdProctestGeneratedBytes bytes;
+  bytes.points = counts[_KindPoints].load(std::memory_order_relaxed);
+  bytes.topology = counts[_KindTopology].load(std::memory_order_relaxed);
+  bytes.primvars = counts[_KindPrimvars].load(std::memory_order_relaxed);
+  return bytes;
+}
+
+} // namespace
+
+UsdProctestDataRefPtr UsdProctestData::New()
+{
+  return TfCreateRefPtr(new UsdProctestData());
+}
+
+UsdProctestData::UsdProctestData()
+  : _serial(_createdCount.fetch_add(1, std::memory_order_relaxed))
+{
+  _liveCount.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(_GetLiveDataMutex());
+  _GetLiveData()[_serial] = this;
+}
+
+UsdProctestData::~UsdProctestData()
+{
+  {
+    std::lock_guard<std::mutex> lock(_GetLiveDataMutex());
+    _GetLiveData().erase(_serial);
+  }
+  _liveCount.fetch_sub(1, std::memory_order_relaxed);
+
+  // Cached values are part of the resident bytes.
+  {
+    std::lock_guard<std::mutex> lock(_GetCacheMutex());
+    while (!_cacheIndex.empty()) {
+      _EvictCached(_cacheIndex.begin()->second);
+    }
+  }
+  for (size_t kind = 0; kind < _KindCount; ++kind) {
+    _globalResidentBytes[kind] -= _residentBytes[kind].load(std::memory_order_relaxed);
+  }
+}
+
+void UsdProctestData::SetImplicitDefault(const SdfPath &attrPath, ValueFn fn,
+                                         size_t heldBytes, bool cacheable)
+{
+  _ReleaseDefault(attrPath);
+  SdfData::Erase(attrPath, SdfFieldKeys->Default);
+
+  _ImplicitDefault implicit;
+  implicit.fn = std::move(fn);
+  implicit.heldBytes = heldBytes;
+  implicit.cacheable = cacheable;
+  const VtValue typeName = SdfData::Get(attrPath, SdfFieldKeys->TypeName);
+  if (typeName.IsHolding<TfToken>()) {
+    const TfType type =
+        SdfSchema::GetInstance().FindType(typeName.UncheckedGet<TfToken>()).GetType();
+    if (!type.IsUnknown()) {
+      implicit.type = &type.GetTypeid();
+    }
+  }
+  _implicitDefaults[attrPath] = std::move(implicit);
+  _AddResidentBytes(attrPath, heldBytes);
+}
+
+bool UsdProctestData::HasImplicitDefault(const SdfPath &attrPath) const
+{
+  return _implicitDefaults.find(attrPath) != _implicitDefaults.end();
+}
+
+UsdProctestGeneratedBytes UsdProctestData::GetResidentBytes() const
+{
+  return _Load(_residentBytes);
+}
+
+UsdProctestGeneratedBytes UsdProctestData::GetGeneratedOnReadBytes() const
+{
+  return _Load(_generatedOnReadBytes);
+}
+
+UsdProctestGeneratedBytes UsdProctestData::GetGlobalResidentBytes()
+{
+  return _Load(_globalResidentBytes);
+}
+
+UsdProctestGeneratedBytes UsdProctestData::GetGlobalGeneratedOnReadBytes()
+{
+  return _Load(_globalGeneratedOnReadBytes);
+}
+
+size_t UsdProctestData::GetCreatedCount()
+{
+  return _createdCount.load(std::memory_order_relaxed);
+}
+
+size_t UsdProctestData::GetLiveCount()
+{
+  return _liveCount.load(std::memory_order_relaxed);
+}
+
+void UsdProctestData::SetLayerIdentifier(const std::string &identifier)
+{
+  std::lock_guard<std::mutex> lock(_GetLiveDataMutex());
+  _layerIdentifier = identifier;
+}
+
+std::string UsdProctestData::GetLayerIdentifier() const
+{
+  std::lock_guard<std::mutex> lock(_GetLiveDataMutex());
+  return _layerIdentifier;
+}
+
+void UsdProctestData::ForEachLiveData(const LiveDataFn &fn)
+{
+  std::lock_guard<std::mutex> lock(_GetLiveDataMutex());
+  const auto &liveData = _GetLiveData();
+  for (auto it = liveData.rbegin(); it != liveData.rend(); ++it) {
+    fn(*it->second, it->second->_layerIdentifier);
+  }
+}
+
+void UsdProctestData::SetImplicitCacheBudget(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_GetCacheMutex());
+  _GetCacheBudget() = bytes;
+  _Cache &cache = _GetCache();
+  while (_globalCachedBytes > bytes && !cache.empty()) {
+    _EvictCached(std::prev(cache.end()));
+  }
+}
+
+size_t UsdProctestData::GetImplicitCacheBudget()
+{
+  return _GetCacheBudget();
+}
+
+const UsdProctestData::_ImplicitDefault *
+UsdProctestData::_FindImplicit(const SdfPath &path, const TfToken &fieldName) const
+{
+  if (fieldName != SdfFieldKeys->Default) {
+    return nullptr;
+  }
+  auto it = _implicitDefaults.find(path);
+  return it == _implicitDefaults.end() ? nullptr : &it->second;
+}
+
+std::mutex &UsdProctestData::_GetCacheMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+UsdProctestData::_Cache &UsdProctestData::_GetCache()
+{
+  static _Cache cache;
+  return cache;
+}
+
+VtValue UsdProctestData::_GetImplicit(const SdfPath &path,
+                                      const _ImplicitDefault &implicit) const
+{
+  if (implicit.cacheable) {
+    std::lock_guard<std::mutex> lock(_GetCacheMutex());
+    auto it = _cacheIndex.find(path);
+    if (it != _cacheIndex.end()) {
+      _Cache &cache = _GetCache();
+      cache.splice(cache.begin(), cache, it->second);
+      return it->second->value;
+    }
+  }
+
+  // Generated outside of the lock, so that different values are generated
+  // concurrently.
+
+  VtValue value = implicit.fn();
+  const size_t bytes = _GetValueBytes(value);
+  const _Kind kind = _GetKind(path);
+  _generatedOnReadBytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+  _globalGeneratedOnReadBytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+  if (implicit.cacheable) {
+    _CacheImplicit(path, value, bytes);
+  }
+  return value;
+}
+
+void UsdProctestData::_CacheImplicit(const SdfPath &path, const VtValue &value,
+                                     size_t bytes) const
+{
+  std::lock_guard<std::mutex> lock(_GetCacheMutex());
+  if (_cacheIndex.find(path) != _cacheIndex.end() || !_ReserveCache(bytes)) {
+    return;
+  }
+  _Cache &cache = _GetCache();
+  cache.push_front({this, path, value, bytes});
+  _cacheIndex[path] = cache.begin();
+  _globalCachedBytes += bytes;
+  _AddResidentBytes(path, bytes);
+}
+
+bool UsdProctestData::_ReserveCache(size_t bytes)
+{
+  const size_t budget = _GetCacheBudget();
+  if (bytes > budget) {
+    return false;
+  }
+  _Cache &cache = _GetCache();
+  while (_globalCachedBytes + bytes > budget && !cache.empty()) {
+    _EvictCached(std::prev(cache.end()));
+  }
+  return true;
+}
+
+void UsdProctestData::_EvictCached(_Cache::iterator it)
+{
+  it->owner->_RemoveResidentBytes(it->path, it->bytes);
+  it->owner->_cacheIndex.erase(it->path);
+  _globalCachedBytes -= it->bytes;
+  _GetCache().erase(it);
+}
+
+void UsdProctestData::_UncacheImplicit(const SdfPath &path)
+{
+  std::lock_guard<std::mutex> lock(_GetCacheMutex());
+  auto it = _cacheIndex.find(path);
+  if (it != _cacheIndex.end()) {
+    _EvictCached(it->second);
+  }
+}
+
+void UsdProctestData::_ReleaseDefault(const SdfPath &path)
+{
+  if (!path.IsPropertyPath()) {
+    return;
+  }
+  _UncacheImplicit(path);
+  auto it = _implicitDefaults.find(path);
+  if (it != _implicitDefaults.end()) {
+    _RemoveResidentBytes(path, it->second.heldBytes);
+    _implicitDefaults.erase(it);
+  }
+  _RemoveResidentBytes(path, _GetValueBytes(SdfData::Get(path, SdfFieldKeys->Default)));
+}
+
+void UsdProctestData::_AddResidentBytes(const SdfPath &path, size_t bytes) const
+{
+  const _Kind kind = _GetKind(path);
+  _residentBytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+  _globalResidentBytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void UsdProctestData::_RemoveResidentBytes(const SdfPath &path, size_t bytes) const
+{
+  const _Kind kind = _GetKind(path);
+  _residentBytes[kind].fetch_sub(bytes, std::memory_order_relaxed);
+  _globalResidentBytes[kind].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool UsdProctestData::Has(const SdfPath &path, const TfToken &fieldName,
+                          SdfAbstractDataValue *value) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    return !value || value->StoreValue(_GetImplicit(path, *implicit));
+  }
+  return SdfData::Has(path, fieldName, value);
+}
+
+bool UsdProctestData::Has(const SdfPath &path, const TfToken &fieldName,
+                          VtValue *value) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    if (value) {
+      *value = _GetImplicit(path, *implicit);
+    }
+    return true;
+  }
+  return SdfData::Has(path, fieldName, value);
+}
+
+bool UsdProctestData::HasSpecAndField(const SdfPath &path, const TfToken &fieldName,
+                                      SdfAbstractDataValue *value,
+                                      SdfSpecType *specType) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    *specType = GetSpecType(path);
+    return !value || value->StoreValue(_GetImplicit(path, *implicit));
+  }
+  return SdfData::HasSpecAndField(path, fieldName, value, specType);
+}
+
+bool UsdProctestData::HasSpecAndField(const SdfPath &path, const TfToken &fieldName,
+                                      VtValue *value, SdfSpecType *specType) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    *specType = GetSpecType(path);
+    if (value) {
+      *value = _GetImplicit(path, *implicit);
+    }
+    return true;
+  }
+  return SdfData::HasSpecAndField(path, fieldName, value, specType);
+}
+
+VtValue UsdProctestData::Get(const SdfPath &path, const TfToken &fieldName) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    return _GetImplicit(path, *implicit);
+  }
+  return SdfData::Get(path, fieldName);
+}
+
+const std::type_info &UsdProctestData::GetTypeid(const SdfPath &path,
+                                                 const TfToken &fieldName) const
+{
+  if (const _ImplicitDefault *implicit = _FindImplicit(path, fieldName)) {
+    return implicit->type ? *implicit->type : _GetImplicit(path, *implicit).GetTypeid();
+  }
+  return SdfData::GetTypeid(path, fieldName);
+}
+
+void UsdProctestData::Set(const SdfPath &path, const TfToken &fieldName,
+                          const VtValue &value)
+{
+  if (value.IsEmpty()) {
+    Erase(path, fieldName);
+    return;
+  }
+  if (fieldName == SdfFieldKeys->Default) {
+    _ReleaseDefault(path);
+    _AddResidentBytes(path, _GetValueBytes(value));
+  }
+  SdfData::Set(path, fieldName, value);
+}
+
+void UsdProctestData::Set(const SdfPath &path, const TfToken &fieldName,
+                          const SdfAbstractDataConstValue &value)
+{
+  if (fieldName == SdfFieldKeys->Default) {
+    _ReleaseDefault(path);
+    VtValue newValue;
+    if (value.GetValue(&newValue)) {
+      _AddResidentBytes(path, _GetValueBytes(newValue));
+    }
+  }
+  SdfData::Set(path, fieldName, value);
+}
+
+void UsdProctestData::Erase(const SdfPath &path, const TfToken &fieldName)
+{
+  if (fieldName == SdfFieldKeys->Default) {
+    _ReleaseDefault(path);
+  }
+  SdfData::Erase(path, fieldName);
+}
+
+std::vector<TfToken> UsdProctestData::List(const SdfPath &path) const
+{
+  std::vector<TfToken> fieldNames = SdfData::List(path);
+  if (HasImplicitDefault(path) &&
+      std::find(fieldNames.begin(), fieldNames.end(), SdfFieldKeys->Default) ==
+          fieldNames.end()) {
+    fieldNames.push_back(SdfFieldKeys->Default);
+  }
+  return fieldNames;
+}
+
+void UsdProctestData::EraseSpec(const SdfPath &path)
+{
+  _ReleaseDefault(path);
+  SdfData::EraseSpec(path);
+}
+
+void UsdProctestData::MoveSpec(const SdfPath &oldPath, const SdfPath &newPath)
+{
+  // The default value is accounted by attribute name, so it is released at
+  // the old path and accounted again at the new one.
+
+  auto it = _implicitDefaults.find(oldPath);
+  const bool isImplicit = it != _implicitDefaults.end();
+  _ImplicitDefault implicit;
+  if (isImplicit) {
+    implicit = it->second;
+  }
+  _ReleaseDefault(oldPath);
+
+  SdfData::MoveSpec(oldPath, newPath);
+
+  if (isImplicit) {
+    _AddResidentBytes(newPath, implicit.heldBytes);
+    _implicitDefaults[newPath] = std::move(implicit);
+  } else if (newPath.IsPropertyPath()) {
+    _AddResidentBytes(newPath, _GetValueBytes(SdfData::Get(newPath, SdfFieldKeys->Default)));
+  }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <pxr/base/tf/declarePtrs.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/data.h>
+#include <pxr/usd/sdf/path.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DECLARE_WEAK_AND_REF_PTRS(UsdProctestData);
+
+// Bytes of generated attribute values, by kind of content.
+struct UsdProctestGeneratedBytes {
+  // points and velocities
+  size_t points = 0;
+  // face vertex counts and indices, and subset indices
+  size_t topology = 0;
+  // primvars and any other array
+  size_t primvars = 0;
+
+  size_t GetTotal() const { return points + topology + primvars; }
+};
+
+// Layer data of generated proctest layers.
+//
+// In addition to the specs and fields stored by SdfData, the default value
+// of some attributes can be made implicit: rather than holding the value,
+// the data holds a function regenerating it from a compact description
+// (typically the cube parameters) each time the field is read. This keeps
+// large regular arrays such as the face vertex indices of a tessellated
+// cube out of resident memory.
+//
+// Implicit values are functions of their captured state only and must be
+// safe to call concurrently, as Sdf reads can happen from many threads.
+// Authoring an implicit field replaces it with a regular stored value.
+// Their type is the one of the attribute value type name, so that queries
+// of the field type do not generate them.
+//
+// Generated values, unless not cacheable, are kept in a cache shared by
+// all proctest data, whose
+// budget is the PROCTEST_IMPLICIT_CACHE_MB environment setting or
+// SetImplicitCacheBudget. Repeated reads of the same implicit value, as
+// made by Usd value resolution and imaging, return the cached array as
+// long as it fits the budget. When it is full, the least recently read
+// values are evicted first, whichever data they belong to.
+//
+// The data accounts for the memory of attribute default values: the bytes
+// resident in the data, either stored, held by implicit values or cached,
+// and the bytes allocated by implicit values each time they are generated. Counts are
+// kept per data and summed over all live data.
+class UsdProctestData : public SdfData {
+public:
+  using ValueFn = std::function<VtValue()>;
+
+  static UsdProctestDataRefPtr New();
+
+  // Serve the default value of the attribute at attrPath by calling fn,
+  // whose captured state holds heldBytes. The attribute spec itself must
+  // exist. Values that are not cacheable are generated on every read, for
+  // values whose compact form is meant to be the only resident one.
+  void SetImplicitDefault(const SdfPath &attrPath, ValueFn fn, size_t heldBytes = 0,
+                          bool cacheable = true);
+  bool HasImplicitDefault(const SdfPath &attrPath) const;
+
+  UsdProctestGeneratedBytes GetResidentBytes() const;
+  UsdProctestGeneratedBytes GetGeneratedOnReadBytes() const;
+
+  // The same, summed over all live proctest data.
+  static UsdProctestGeneratedBytes GetGlobalResidentBytes();
+  static UsdProctestGeneratedBytes GetGlobalGeneratedOnReadBytes();
+
+  // Set the bytes of generated implicit values that may be cached, over
+  // all proctest data, evicting the values beyond it. Zero disables the
+  // cache.
+  static void SetImplicitCacheBudget(size_t bytes);
+  static size_t GetImplicitCacheBudget();
+
+  // Number of proctest data created since startup, and of those still
+  // alive, which tell whether layers were regenerated.
+  static size_t GetCreatedCount();
+  static size_t GetLiveCount();
+
+  // Identifier of the layer the data is the content of, set by the file
+  // format, which finds the data of a layer among the live data.
+  void SetLayerIdentifier(const std::string &identifier);
+  std::string GetLayerIdentifier() const;
+
+  // Call fn with each live proctest data and its layer identifier, most
+  // recently created first, under a lock that keeps them alive. fn must not
+  // create nor release proctest data, nor set their layer identifier.
+  using LiveDataFn =
+      std::function<void(const UsdProctestData &, const std::string &layerIdentifier)>;
+  static void ForEachLiveData(const LiveDataFn &fn);
+
+  // Fingerprint of the arguments and generator the data was generated
+  // with, letting reloads with unchanged arguments skip regeneration.
+  void SetFingerprint(uint64_t fingerprint) { _fingerprint = fingerprint; }
+  uint64_t GetFingerprint() const { return _fingerprint; }
+
+  // Reported so that Sdf replaces the data of a reloaded layer wholesale
+  // rather than diffing the new data into the current one, which would
+  // keep the current fingerprint and store the implicit values.
+  bool StreamsData() const override { return true; }
+
+  bool Has(const SdfPath &path, const TfToken &fieldName,
+           SdfAbstractDataValue *value) const override;
+  bool Has(const SdfPath &path, const TfToken &fieldName,
+           VtValue *value = nullptr) const override;
+  bool HasSpecAndField(const SdfPath &path, const TfToken &fieldName,
+                       SdfAbstractDataValue *value, SdfSpecType *specType) const override;
+  bool HasSpecAndField(const SdfPath &path, const TfToken &fieldName,
+                       VtValue *value, SdfSpecType *specType) const override;
+  VtValue Get(const SdfPath &path, const TfToken &fieldName) const override;
+  const std::type_info &GetTypeid(const SdfPath &path,
+                                  const TfToken &fieldName) const override;
+  void Set(const SdfPath &path, const TfToken &fieldName,
+           const VtValue &value) override;
+  void Set(const SdfPath &path, const TfToken &fieldName,
+           const SdfAbstractDataConstValue &value) override;
+  void Erase(const SdfPath &path, const TfToken &fieldName) override;
+  std::vector<TfToken> List(const SdfPath &path) const override;
+  void EraseSpec(const SdfPath &path) override;
+  void MoveSpec(const SdfPath &oldPath, const SdfPath &newPath) override;
+
+protected:
+  UsdProctestData();
+  ~UsdProctestData() override;
+
+private:
+  struct _ImplicitDefault {
+    ValueFn fn;
+    // Type of the generated values, null if the attribute has no known
+    // value type name.
+    const std::type_info *type = nullptr;
+    size_t heldBytes = 0;
+    bool cacheable = true;
+  };
+
+  // A cached implicit value of owner, in the process-wide most recently
+  // read first list.
+  struct _CachedValue {
+    const UsdProctestData *owner = nullptr;
+    SdfPath path;
+    VtValue value;
+    size_t bytes = 0;
+  };
+  using _Cache = std::list<_CachedValue>;
+
+  // One count per member of UsdProctestGeneratedBytes.
+  using _ByteCounts = std::atomic<size_t>[3];
+
+  const _ImplicitDefault *_FindImplicit(const SdfPath &path, const TfToken &fieldName) const;
+  // Return the implicit value at path, from the cache or generated.
+  VtValue _GetImplicit(const SdfPath &path, const _ImplicitDefault &implicit) const;
+  void _CacheImplicit(const SdfPath &path, const VtValue &value, size_t bytes) const;
+  void _UncacheImplicit(const SdfPath &path);
+
+  // The cache shared by all data, and the mutex guarding it, the cache
+  // index of every data and the cached bytes.
+  static std::mutex &_GetCacheMutex();
+  static _Cache &_GetCache();
+  // Evict the least recently read values, of any data, until the cached
+  // bytes plus bytes fit the budget. Return false if bytes alone do not fit
+  // it. Requires the cache mutex.
+  static bool _ReserveCache(size_t bytes);
+  // Remove a cached value from the cache and the index of its owner.
+  // Requires the cache mutex.
+  static void _EvictCached(_Cache::iterator it);
+
+  // Stop accounting for the default value at path, stored or implicit, and
+  // forget the implicit one.
+  void _ReleaseDefault(const SdfPath &path);
+  void _AddResidentBytes(const SdfPath &path, size_t bytes) const;
+  void _RemoveResidentBytes(const SdfPath &path, size_t bytes) const;
+
+  std::unordered_map<SdfPath, _ImplicitDefault, SdfPath::Hash> _implicitDefaults;
+  // The cached values of this data, guarded by the cache mutex.
+  mutable std::unordered_map<SdfPath, _Cache::iterator, SdfPath::Hash> _cacheIndex;
+  uint64_t _fingerprint = 0;
+  // Creation order, and layer identifier guarded by the live data mutex.
+  size_t _serial = 0;
+  std::string _layerIdentifier;
+  mutable _ByteCounts _residentBytes = {};
+  mutable _ByteCounts _generatedOnReadBytes = {};
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
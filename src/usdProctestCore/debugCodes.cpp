@@ -0,0 +1,11 @@
+#include "debugCodes.h"
+
+#include <pxr/base/tf/registryManager.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_REGISTRY_FUNCTION(TfDebug) {
+  TF_DEBUG_ENVIRONMENT_SYMBOL(PROCTEST_INFO, "Proctest generation information.");
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pxr/base/tf/debug.h>
+#include <pxr/pxr.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEBUG_CODES(
+  PROCTEST_INFO
+);
+
+PXR_NAMESPACE_CLOSE_SCOPE
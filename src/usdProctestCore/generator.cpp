@@ -0,0 +1,333 @@
+#include "generator.h"
+
+#include "chunks.h"
+
+#include <pxr/base/gf/bbox3d.h>
+#include <pxr/base/gf/matrix4f.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/work/loops.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Outward normal and grid axes of a cube side, normal = u ^ v so that
+// quads wound along u then v face outward.
+struct _Side {
+  GfVec3f normal;
+  GfVec3f u;
+  GfVec3f v;
+};
+
+const _Side _sides[UsdProctestCubeSideCount] = {
+  {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+  {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+  {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+  {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+  {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+  {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+};
+
+const char *_sideNames[UsdProctestCubeSideCount] = {
+  "posX", "negX", "posY", "negY", "posZ", "negZ",
+};
+
+// Addressing of the points and faces of a cube from their index.
+struct _CubeGrid {
+  explicit _CubeGrid(const UsdProctestCubeParams &params)
+    : divisions(static_cast<size_t>(params.divisions))
+    , rowPoints(divisions + 1)
+    , sidePoints(rowPoints * rowPoints)
+    , sideFaces(divisions * divisions)
+    , pointCount(UsdProctestCubeSideCount * sidePoints)
+    , faceCount(UsdProctestCubeSideCount * sideFaces) {}
+
+  // Position of point k on a cube of side length 2, scaled by scale.
+  GfVec3f GetPoint(size_t k, float scale) const {
+    const _Side &side = _sides[k / sidePoints];
+    const size_t r = k % sidePoints;
+    const float i = static_cast<float>(r % rowPoints);
+    const float j = static_cast<float>(r / rowPoints);
+    const float n = static_cast<float>(divisions);
+    return side.normal * scale
+         + side.u * (scale * (2.0f * i - n) / n)
+         + side.v * (scale * (2.0f * j - n) / n);
+  }
+
+  // Write the 4 vertex indices of face q, offset by pointOffset.
+  void GetFaceVertexIndices(size_t q, std::ptrdiff_t pointOffset, int *face) const {
+    const size_t r = q % sideFaces;
+    const int corner = static_cast<int>(
+        static_cast<std::ptrdiff_t>((q / sideFaces) * sidePoints
+                                    + (r / divisions) * rowPoints
+                                    + r % divisions)
+        + pointOffset);
+    face[0] = corner;
+    face[1] = corner + 1;
+    face[2] = corner + 1 + static_cast<int>(rowPoints);
+    face[3] = corner + static_cast<int>(rowPoints);
+  }
+
+  size_t divisions;
+  size_t rowPoints;
+  size_t sidePoints;
+  size_t sideFaces;
+  size_t pointCount;
+  size_t faceCount;
+};
+
+// Generate, for each point of range, its position on a cube of side length 2
+// scaled by scale.
+VtVec3fArray _GenerateCubeVectors(const UsdProctestCubeParams &params,
+                                  const UsdProctestCubeRange &range,
+                                  float scale)
+{
+  const _CubeGrid grid(params);
+
+  VtVec3fArray vectors;
+  vectors.resize(range.pointEnd - range.pointBegin, [&](GfVec3f *b, GfVec3f *e) {
+    UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+      for (size_t p = begin; p < end; ++p) {
+        b[p] = grid.GetPoint(range.pointBegin + p, scale);
+      }
+    });
+  });
+  return vectors;
+}
+
+} // namespace
+
+size_t UsdProctestGetCubePointCount(const UsdProctestCubeParams &params)
+{
+  const size_t rowPoints = static_cast<size_t>(params.divisions) + 1;
+  return UsdProctestCubeSideCount * rowPoints * rowPoints;
+}
+
+size_t UsdProctestGetCubeFaceCount(const UsdProctestCubeParams &params)
+{
+  const size_t divisions = static_cast<size_t>(params.divisions);
+  return UsdProctestCubeSideCount * divisions * divisions;
+}
+
+const char *UsdProctestGetCubeSideName(size_t side)
+{
+  return _sideNames[side];
+}
+
+UsdProctestCubeParams UsdProctestGetCubeLodParams(const UsdProctestCubeParams &params,
+                                                  int level)
+{
+  UsdProctestCubeParams lodParams = params;
+  for (int i = 0; i < level && lodParams.divisions > 1; ++i) {
+    lodParams.divisions /= 2;
+  }
+  return lodParams;
+}
+
+int UsdProctestGetCubeLodCount(const UsdProctestCubeParams &params)
+{
+  int count = 1;
+  for (int divisions = params.divisions; divisions > 1; divisions /= 2) {
+    ++count;
+  }
+  return count;
+}
+
+UsdProctestCubeRange UsdProctestGetCubeRange(const UsdProctestCubeParams &params)
+{
+  UsdProctestCubeRange range;
+  range.faceEnd = UsdProctestGetCubeFaceCount(params);
+  range.pointEnd = UsdProctestGetCubePointCount(params);
+  return range;
+}
+
+std::vector<UsdProctestCubeRange> UsdProctestSplitCube(const UsdProctestCubeParams &params,
+                                                       size_t maxFaces)
+{
+  const _CubeGrid grid(params);
+  const size_t rowCount = UsdProctestCubeSideCount * grid.divisions;
+  const size_t rowsPerRange = std::max<size_t>(1, maxFaces / grid.divisions);
+
+  // Rows are numbered across sides. The faces of consecutive rows are
+  // contiguous, and so are their points even across sides, since the points
+  // of a side follow those of the previous one.
+
+  const auto getFirstPoint = [&grid](size_t row) {
+    return (row / grid.divisions) * grid.sidePoints + (row % grid.divisions) * grid.rowPoints;
+  };
+
+  std::vector<UsdProctestCubeRange> ranges;
+  for (size_t row = 0; row < rowCount; row += rowsPerRange) {
+    const size_t rowEnd = std::min(row + rowsPerRange, rowCount);
+    UsdProctestCubeRange range;
+    range.faceBegin = row * grid.divisions;
+    range.faceEnd = rowEnd * grid.divisions;
+    range.pointBegin = getFirstPoint(row);
+    // The last row uses the points of the row after it.
+    range.pointEnd = getFirstPoint(rowEnd - 1) + 2 * grid.rowPoints;
+    ranges.push_back(range);
+  }
+  return ranges;
+}
+
+VtVec3fArray UsdProctestGenerateCubePoints(const UsdProctestCubeParams &params)
+{
+  return UsdProctestGenerateCubePoints(params, UsdProctestGetCubeRange(params));
+}
+
+VtVec3fArray UsdProctestGenerateCubePoints(const UsdProctestCubeParams &params,
+                                           const UsdProctestCubeRange &range)
+{
+  return _GenerateCubeVectors(params, range, params.sideLength / 2.0f);
+}
+
+VtVec3fArray UsdProctestGenerateCubeVelocities(const UsdProctestCubeParams &params)
+{
+  // Points are linear in the side length, their time derivative is the
+  // same vector field scaled by the side length rate.
+  return _GenerateCubeVectors(params, UsdProctestGetCubeRange(params),
+                              params.sideLengthRate / 2.0f);
+}
+
+VtIntArray UsdProctestGenerateCubeFaceVertexCounts(const UsdProctestCubeParams &,
+                                                   const UsdProctestCubeRange &range)
+{
+  return VtIntArray(range.faceEnd - range.faceBegin, 4);
+}
+
+VtIntArray UsdProctestGenerateCubeFaceVertexIndices(const UsdProctestCubeParams &params,
+                                                    const UsdProctestCubeRange &range)
+{
+  const _CubeGrid grid(params);
+  const size_t faceCount = range.faceEnd - range.faceBegin;
+
+  VtIntArray faceVertexIndices;
+  faceVertexIndices.resize(4 * faceCount, [&](int *b, int *) {
+    UsdProctestForEachChunk(faceCount, [&](size_t, size_t begin, size_t end) {
+      for (size_t f = begin; f < end; ++f) {
+        grid.GetFaceVertexIndices(range.faceBegin + f,
+                                  -static_cast<std::ptrdiff_t>(range.pointBegin),
+                                  b + 4 * f);
+      }
+    });
+  });
+  return faceVertexIndices;
+}
+
+bool UsdProctestCanMergeCubes(const UsdProctestCubeParams &params, size_t instanceCount)
+{
+  const _CubeGrid grid(params);
+  const size_t maxIndex = static_cast<size_t>(std::numeric_limits<int>::max());
+  return instanceCount <= maxIndex / grid.pointCount &&
+         instanceCount <= maxIndex / (4 * grid.faceCount);
+}
+
+VtVec3fArray UsdProctestGenerateMergedCubePoints(
+    const UsdProctestCubeParams &params,
+    const std::vector<UsdProctestCubeInstance> &instances)
+{
+  const _CubeGrid grid(params);
+
+  std::vector<GfMatrix4f> transforms(instances.size());
+  for (size_t i = 0; i < instances.size(); ++i) {
+    transforms[i] = GfMatrix4f(instances[i].transform);
+  }
+
+  // Instances are flattened, so that chunks are spread evenly whatever the
+  // number of instances and their size.
+
+  VtVec3fArray points;
+  points.resize(instances.size() * grid.pointCount, [&](GfVec3f *b, GfVec3f *e) {
+    UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+      for (size_t p = begin; p < end; ++p) {
+        const size_t instance = p / grid.pointCount;
+        b[p] = transforms[instance].Transform(
+            grid.GetPoint(p % grid.pointCount, instances[instance].sideLength / 2.0f));
+      }
+    });
+  });
+  return points;
+}
+
+VtIntArray UsdProctestGenerateMergedCubeFaceVertexCounts(const UsdProctestCubeParams &params,
+                                                         size_t instanceCount)
+{
+  return VtIntArray(instanceCount * UsdProctestGetCubeFaceCount(params), 4);
+}
+
+VtIntArray UsdProctestGenerateMergedCubeFaceVertexIndices(const UsdProctestCubeParams &params,
+                                                          size_t instanceCount)
+{
+  const _CubeGrid grid(params);
+  const size_t faceCount = instanceCount * grid.faceCount;
+
+  VtIntArray faceVertexIndices;
+  faceVertexIndices.resize(4 * faceCount, [&](int *b, int *) {
+    UsdProctestForEachChunk(faceCount, [&](size_t, size_t begin, size_t end) {
+      for (size_t q = begin; q < end; ++q) {
+        grid.GetFaceVertexIndices(q % grid.faceCount,
+                                  static_cast<std::ptrdiff_t>((q / grid.faceCount)
+                                                              * grid.pointCount),
+                                  b + 4 * q);
+      }
+    });
+  });
+  return faceVertexIndices;
+}
+
+VtIntArray UsdProctestGenerateMergedCubeSideFaceIndices(const UsdProctestCubeParams &params,
+                                                        size_t side,
+                                                        size_t instanceCount)
+{
+  const _CubeGrid grid(params);
+  const size_t firstFace = side * grid.sideFaces;
+
+  VtIntArray faceIndices;
+  faceIndices.resize(instanceCount * grid.sideFaces, [&](int *b, int *e) {
+    UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+      for (size_t f = begin; f < end; ++f) {
+        b[f] = static_cast<int>((f / grid.sideFaces) * grid.faceCount
+                                + firstFace + f % grid.sideFaces);
+      }
+    });
+  });
+  return faceIndices;
+}
+
+std::vector<GfRange3f> UsdProctestComputeMergedCubeBounds(
+    const std::vector<UsdProctestCubeInstance> &instances)
+{
+  std::vector<GfRange3f> bounds(instances.size());
+  WorkParallelForN(instances.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const double halfLength = instances[i].sideLength / 2.0;
+      const GfRange3d cube(GfVec3d(-halfLength), GfVec3d(halfLength));
+      const GfRange3d range = GfBBox3d(cube, instances[i].transform).ComputeAlignedRange();
+      bounds[i] = GfRange3f(GfVec3f(range.GetMin()), GfVec3f(range.GetMax()));
+    }
+  });
+  return bounds;
+}
+
+VtIntArray UsdProctestGenerateMergedCubeInstanceIds(const UsdProctestCubeParams &params,
+                                                    size_t instanceCount)
+{
+  const _CubeGrid grid(params);
+
+  VtIntArray instanceIds;
+  instanceIds.resize(instanceCount * grid.faceCount, [&](int *b, int *e) {
+    UsdProctestForEachChunk(e - b, [&](size_t, size_t begin, size_t end) {
+      for (size_t q = begin; q < end; ++q) {
+        b[q] = static_cast<int>(q / grid.faceCount);
+      }
+    });
+  });
+  return instanceIds;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
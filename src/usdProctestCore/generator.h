@@ -0,0 +1,121 @@
+#pragma once
+
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/pxr.h>
+
+#include <cstddef>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Version of the generator, to bump whenever its output changes so that
+// content generated by a previous version is not reused.
+constexpr int UsdProctestGeneratorVersion = 2;
+
+// Largest number of divisions keeping every face vertex index of a
+// generated cube representable as an int.
+constexpr int UsdProctestMaxCubeDivisions = 9000;
+
+// Parameters of a procedural cube centered on the origin. Each side of the
+// cube is a grid of divisions x divisions quads with its own points.
+struct UsdProctestCubeParams {
+  float sideLength = 1.0f;
+  int divisions = 1;
+  // Time derivative of the side length, in units per second.
+  float sideLengthRate = 0.0f;
+};
+
+// Number of sides of a cube. Sides are ordered +X, -X, +Y, -Y, +Z, -Z, and
+// the faces and points of a side are contiguous.
+constexpr size_t UsdProctestCubeSideCount = 6;
+
+// A contiguous range of faces of a cube and the contiguous range of points
+// they use.
+struct UsdProctestCubeRange {
+  size_t faceBegin = 0;
+  size_t faceEnd = 0;
+  size_t pointBegin = 0;
+  size_t pointEnd = 0;
+};
+
+size_t UsdProctestGetCubePointCount(const UsdProctestCubeParams &params);
+size_t UsdProctestGetCubeFaceCount(const UsdProctestCubeParams &params);
+
+// Return the name of a cube side, e.g. "posX".
+const char *UsdProctestGetCubeSideName(size_t side);
+
+// Return the parameters of the cube at a level of detail, each level halving
+// the divisions of the previous one down to a single quad per side. Level 0
+// is the cube itself.
+UsdProctestCubeParams UsdProctestGetCubeLodParams(const UsdProctestCubeParams &params,
+                                                  int level);
+
+// Return the number of distinct levels of detail of the cube, past which
+// levels would repeat the single quad per side of the last one.
+int UsdProctestGetCubeLodCount(const UsdProctestCubeParams &params);
+
+// Return the range covering the whole cube.
+UsdProctestCubeRange UsdProctestGetCubeRange(const UsdProctestCubeParams &params);
+
+// Split the cube into ranges of consecutive rows of quads holding at most
+// maxFaces faces each, or a single row when a row is larger than maxFaces.
+// Ranges span sides, so that small cubes are a single range.
+std::vector<UsdProctestCubeRange> UsdProctestSplitCube(const UsdProctestCubeParams &params,
+                                                       size_t maxFaces);
+
+// The generators below allocate their output once, at its final size, and
+// fill it in place by processing fixed-size chunks in parallel, so that no
+// intermediate buffer is grown or copied whatever the size of the cube.
+// Each element only depends on its index, never on the chunks other
+// threads processed, so the output does not depend on the thread count.
+
+// Face vertex indices generated for a range are relative to the first point
+// of the range.
+
+VtVec3fArray UsdProctestGenerateCubePoints(const UsdProctestCubeParams &params);
+VtVec3fArray UsdProctestGenerateCubePoints(const UsdProctestCubeParams &params,
+                                           const UsdProctestCubeRange &range);
+// Velocities of the points, derived analytically from the side length rate.
+VtVec3fArray UsdProctestGenerateCubeVelocities(const UsdProctestCubeParams &params);
+VtIntArray UsdProctestGenerateCubeFaceVertexCounts(const UsdProctestCubeParams &params,
+                                                   const UsdProctestCubeRange &range);
+VtIntArray UsdProctestGenerateCubeFaceVertexIndices(const UsdProctestCubeParams &params,
+                                                    const UsdProctestCubeRange &range);
+
+// An instance of a merged layout of cubes. Instances share the divisions of
+// the layout parameters.
+struct UsdProctestCubeInstance {
+  GfMatrix4d transform = GfMatrix4d(1.0);
+  float sideLength = 1.0f;
+};
+
+// Merged meshes concatenate the cubes of instanceCount instances, the points
+// and faces of an instance following those of the previous one. They are
+// generated in parallel across all instances, directly into the merged
+// arrays.
+
+// Return true if the indices of the merged mesh are representable as ints.
+bool UsdProctestCanMergeCubes(const UsdProctestCubeParams &params, size_t instanceCount);
+
+VtVec3fArray UsdProctestGenerateMergedCubePoints(
+    const UsdProctestCubeParams &params,
+    const std::vector<UsdProctestCubeInstance> &instances);
+VtIntArray UsdProctestGenerateMergedCubeFaceVertexCounts(const UsdProctestCubeParams &params,
+                                                         size_t instanceCount);
+VtIntArray UsdProctestGenerateMergedCubeFaceVertexIndices(const UsdProctestCubeParams &params,
+                                                          size_t instanceCount);
+VtIntArray UsdProctestGenerateMergedCubeSideFaceIndices(const UsdProctestCubeParams &params,
+                                                        size_t side,
+                                                        size_t instanceCount);
+// Axis aligned bounds of each instance, computed analytically from its
+// transform and side length.
+std::vector<GfRange3f> UsdProctestComputeMergedCubeBounds(
+    const std::vector<UsdProctestCubeInstance> &instances);
+// Index of the instance of each face.
+VtIntArray UsdProctestGenerateMergedCubeInstanceIds(const UsdProctestCubeParams &params,
+                                                    size_t instanceCount);
+
+PXR_NAMESPACE_CLOSE_SCOPE
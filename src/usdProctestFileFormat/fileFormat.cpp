@@ -1,18 +1,48 @@
 #include "fileFormat.h"
+#include "accounting.h"
+#include "bake.h"
+#include "bvh.h"
+#include "compactPoints.h"
+#include "data.h"
+#include "debugCodes.h"
+#include "generator.h"
 
 #include <pxr/pxr.h>
 
+#include <pxr/base/arch/demangle.h>
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/tf/debug.h>
 #include <pxr/base/tf/diagnostic.h>
+#include <pxr/base/tf/envSetting.h>
+#include <pxr/base/tf/pathUtils.h>
 #include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/vt/dictionary.h>
 #include <pxr/usd/pcp/dynamicFileFormatContext.h>
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/sdf/primSpec.h>
+#include <pxr/usd/usd/editContext.h>
 #include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usd/references.h>
+#include <pxr/usd/usd/schemaRegistry.h>
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/usdaFileFormat.h>
+#include <pxr/usd/usd/variantSets.h>
 #include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/primvarsAPI.h>
+#include <pxr/usd/usdGeom/subset.h>
+#include <pxr/usd/usdProcTest/myProcMesh.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <iostream>
@@ -21,7 +51,14 @@ using namespace std;
 
 PXR_NAMESPACE_OPEN_SCOPE
 
-static const float defaultSideLengthValue = 1.0f;
+// Defaults of the cube parameters. The MyProcMesh schema attributes have no
+// fallback and default to the same UsdProctestCubeParams.
+static const float defaultSideLengthValue = UsdProctestCubeParams().sideLength;
+static const float defaultSideLengthRateValue = UsdProctestCubeParams().sideLengthRate;
+static const int defaultDivisionsValue = UsdProctestCubeParams().divisions;
+static const bool defaultSideSubsetsValue = false;
+static const int defaultLodCountValue = 1;
+static const int defaultLodValue = 0;
 
 TF_DEFINE_PUBLIC_TOKENS(UsdProctestFileFormatTokens, USD_PROCTEST_FILE_FORMAT_TOKENS);
 
@@ -29,70 +66,462 @@ TF_REGISTRY_FUNCTION(TfType) {
   SDF_DEFINE_FILE_FORMAT(UsdProctestFileFormat, SdfFileFormat);
 }
 
-enum ProctestCodes { PROCTEST_CANNOT_READ_PROCTEST_FILE, PROCTEST_CANNOT_CREATE_ATTRIBUTE };
+enum ProctestCodes { PROCTEST_CANNOT_READ_PROCTEST_FILE, PROCTEST_CANNOT_CREATE_ATTRIBUTE, PROCTEST_CANNOT_BAKE };
 TF_REGISTRY_FUNCTION(TfEnum) {
     TF_ADD_ENUM_NAME(PROCTEST_CANNOT_READ_PROCTEST_FILE, "Cannot read Proctest file.");
     TF_ADD_ENUM_NAME(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "Cannot create attribute.");
+    TF_ADD_ENUM_NAME(PROCTEST_CANNOT_BAKE, "Cannot bake Proctest file.");
 };
 
-TF_DEBUG_CODES(
-  PROCTEST_INFO
-);
+TF_DEFINE_ENV_SETTING(PROCTEST_REPORT_INTERVAL, 0,
+                      "Seconds between reports of the generated bytes through the "
+                      "PROCTEST_INFO debug flag, 0 to disable them.");
 
-static float
-_ExtractSideLengthFromContext(const PcpDynamicFileFormatContext& context)
+// The reporter started by PROCTEST_REPORT_INTERVAL. It is stopped by an
+// atexit handler rather than by static destruction, where its thread could
+// still be reading data being destroyed.
+static UsdProctestGeneratedBytesReporter *_reporter = nullptr;
+
+static void
+_StopReporter()
 {
-    // Default sideLength.
-    auto sideLength = defaultSideLengthValue;
+    delete _reporter;
+    _reporter = nullptr;
+}
 
+template <typename T>
+static T
+_ExtractValueFromContext(const PcpDynamicFileFormatContext& context,
+                         const TfToken& field,
+                         const T& defaultValue)
+{
     VtValue value;
-    if (!context.ComposeValue(UsdProctestFileFormatTokens->SideLength,
-                              &value) ||
+    if (!context.ComposeValue(field, &value) ||
         value.IsEmpty()) {
-        return sideLength;
+        return defaultValue;
     }
 
-    if (!value.IsHolding<float>()) {
-        TF_CODING_ERROR("Expected '%s' value to hold a float, got '%s'",
-                        UsdProctestFileFormatTokens->SideLength.GetText(),
+    if (!value.IsHolding<T>()) {
+        TF_CODING_ERROR("Expected '%s' value to hold a %s, got '%s'",
+                        field.GetText(),
+                        ArchGetDemangled<T>().c_str(),
                         TfStringify(value).c_str());
-        return sideLength;
+        return defaultValue;
     }
 
-    return value.UncheckedGet<float>();
+    return value.UncheckedGet<T>();
 }
 
-static auto
-_ExtractSideLengthFromArgs(const SdfFileFormat::FileFormatArguments& args)
+template <typename T>
+static T
+_ExtractValueFromArgs(const SdfFileFormat::FileFormatArguments& args,
+                      const TfToken& field,
+                      const T& defaultValue)
 {
-    // Default sideLength.
-    float sideLength = defaultSideLengthValue;
-
-    // Find "sideLength" file format argument.
-    auto it = args.find(UsdProctestFileFormatTokens->SideLength);
+    // Find the file format argument.
+    auto it = args.find(field);
     if (it == args.end()) {
-        return sideLength;
+        return defaultValue;
     }
 
     // Try to convert the string value to the actual output value type.
-    float extractVal;
     bool success = true;
-    extractVal = TfUnstringify<float>(it->second, &success);
+    T extractVal = TfUnstringify<T>(it->second, &success);
     if (!success) {
         TF_CODING_ERROR(
-            "Could not convert arg string '%s' to value of type float",
-            UsdProctestFileFormatTokens->SideLength.GetText());
-        return sideLength;
+            "Could not convert arg string '%s' to value of type %s",
+            field.GetText(),
+            ArchGetDemangled<T>().c_str());
+        return defaultValue;
+    }
+
+    return extractVal;
+}
+
+template <typename T>
+static bool
+_HasValueChanged(const VtValue& oldValue,
+                 const VtValue& newValue,
+                 const T& defaultValue)
+{
+    const T oldT = oldValue.IsHolding<T>() ? oldValue.UncheckedGet<T>()
+                                           : defaultValue;
+    const T newT = newValue.IsHolding<T>() ? newValue.UncheckedGet<T>()
+                                           : defaultValue;
+    return oldT != newT;
+}
+
+static UsdProctestCubeParams
+_ExtractCubeParamsFromArgs(const SdfFileFormat::FileFormatArguments& args)
+{
+    UsdProctestCubeParams params;
+    params.sideLength = _ExtractValueFromArgs(
+        args, UsdProctestFileFormatTokens->SideLength, defaultSideLengthValue);
+    params.divisions = _ExtractValueFromArgs(
+        args, UsdProctestFileFormatTokens->Divisions, defaultDivisionsValue);
+    params.sideLengthRate = _ExtractValueFromArgs(
+        args, UsdProctestFileFormatTokens->SideLengthRate, defaultSideLengthRateValue);
+
+    if (params.divisions < 1 || params.divisions > UsdProctestMaxCubeDivisions) {
+        TF_WARN("'%s' value %d is out of range [1, %d], clamping",
+                UsdProctestFileFormatTokens->Divisions.GetText(),
+                params.divisions, UsdProctestMaxCubeDivisions);
+        params.divisions = std::max(1, std::min(params.divisions,
+                                                UsdProctestMaxCubeDivisions));
+    }
+
+    return params;
+}
+
+// Return the name of the variant of a level of detail, e.g. "lod0".
+static std::string
+_GetLodVariantName(int level)
+{
+    return TfStringPrintf("lod%d", level);
+}
+
+// Return the arguments the generated content depends on, canonicalized
+// through their parsed values so that equivalent spellings match.
+static std::string
+_GetCanonicalArguments(const SdfFileFormat::FileFormatArguments& args,
+                       const UsdProctestCubeParams& params)
+{
+    auto getArg = [&args](const TfToken& field) {
+        auto it = args.find(field);
+        return it == args.end() ? std::string() : it->second;
+    };
+
+    // Levels are clamped as when reading, so that out of range levels hash
+    // as the level they select.
+    const int lodCount = std::max(
+        1, std::min(_ExtractValueFromArgs(args, UsdProctestFileFormatTokens->LodCount,
+                                          defaultLodCountValue),
+                    UsdProctestGetCubeLodCount(params)));
+    const int lod = std::max(
+        0, std::min(_ExtractValueFromArgs(args, UsdProctestFileFormatTokens->Lod,
+                                          defaultLodValue),
+                    lodCount - 1));
+
+    return TfStringPrintf(
+        "%d %.9g %d %.9g %d %d %d %s %s",
+        UsdProctestGeneratorVersion,
+        params.sideLength,
+        params.divisions,
+        params.sideLengthRate,
+        _ExtractValueFromArgs(args, UsdProctestFileFormatTokens->SideSubsets,
+                              defaultSideSubsetsValue) ? 1 : 0,
+        lodCount,
+        lod,
+        getArg(UsdProctestFileFormatTokens->PointsPrecision).c_str(),
+        getArg(UsdProctestFileFormatTokens->BakePath).c_str());
+}
+
+// Return a fingerprint of everything the generated content depends on: the
+// canonical arguments, the generator version and the proctest file itself.
+static uint64_t
+_ComputeFingerprint(const SdfFileFormat::FileFormatArguments& args,
+                    const UsdProctestCubeParams& params,
+                    const std::string& resolvedPath)
+{
+    double modificationTime = 0.0;
+    ArchGetModificationTime(resolvedPath.c_str(), &modificationTime);
+
+    const std::string fingerprint = TfStringPrintf(
+        "%s %s %.17g %s",
+        UsdProctestFileFormatTokens->Version.GetText(),
+        resolvedPath.c_str(),
+        modificationTime,
+        _GetCanonicalArguments(args, params).c_str());
+    return ArchHash64(fingerprint.c_str(), fingerprint.size());
+}
+
+// Return a hash of the generated content. Generation is deterministic, see
+// testUsdProctestDeterminism, so the content only depends on the canonical
+// arguments, the instances and the type of the generated prim, and is
+// hashed without hashing its arrays. Baked content is hashed through the
+// files of the bake instead, see UsdProctestHashBakeFiles.
+static uint64_t
+_ComputeContentHash(const SdfFileFormat::FileFormatArguments& args,
+                    const UsdProctestCubeParams& params,
+                    const std::vector<UsdProctestCubeInstance>& instances,
+                    const TfToken& primTypeName)
+{
+    const std::string canonical = _GetCanonicalArguments(args, params);
+    uint64_t hash = ArchHash64(canonical.c_str(), canonical.size());
+    hash = ArchHash64(primTypeName.GetText(), primTypeName.size(), hash);
+    for (const UsdProctestCubeInstance& instance : instances) {
+        hash = ArchHash64(reinterpret_cast<const char*>(instance.transform.data()),
+                          16 * sizeof(double), hash);
+        hash = ArchHash64(reinterpret_cast<const char*>(&instance.sideLength),
+                          sizeof(instance.sideLength), hash);
     }
+    return hash;
+}
 
-    sideLength = extractVal;
-    return sideLength;
+// Record the content hash in the custom layer data of layer.
+static void
+_SetContentHash(const SdfLayerHandle& layer, uint64_t contentHash)
+{
+    VtDictionary customLayerData = layer->GetCustomLayerData();
+    customLayerData[UsdProctestFileFormatTokens->ContentHash.GetString()] =
+        TfStringPrintf("%016llx", static_cast<unsigned long long>(contentHash));
+    layer->SetCustomLayerData(customLayerData);
+}
+
+// Generate a layer serving the cube from its bake at bakePath, baking it
+// first if needed. The layer only references the bake, so the geometry is
+// read from the memory-mapped crate file instead of being held by the layer.
+// As for a generated single cube, the loaded prim is a MyProcMesh whose
+// schema attributes hold the parameters, its geometry being the chunk
+// meshes of the bake below it.
+static SdfLayerRefPtr
+_GenerateBakedLayer(const UsdProctestCubeParams& params,
+                    const std::string& bakePath)
+{
+    if (!UsdProctestIsBakeUpToDate(params, bakePath) &&
+        !UsdProctestBakeCube(params, bakePath)) {
+        TF_ERROR(PROCTEST_CANNOT_BAKE, "%s", bakePath.c_str());
+        return SdfLayerRefPtr();
+    }
+
+    SdfLayerRefPtr newLayer = SdfLayer::CreateAnonymous(".usd");
+    UsdStageRefPtr stage = UsdStage::Open(newLayer);
+    const UsdProcTestMyProcMesh procMesh =
+        UsdProcTestMyProcMesh::Define(stage, SdfPath("/Root"));
+    if (!TF_VERIFY(procMesh)) {
+        return SdfLayerRefPtr();
+    }
+    if (!procMesh.CreateLengthAttr(VtValue(params.sideLength))) {
+        TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "length");
+    }
+    if (!procMesh.CreateDivisionsAttr(VtValue(params.divisions))) {
+        TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "divisions");
+    }
+    procMesh.GetPrim().GetReferences().AddReference(bakePath);
+    stage->SetDefaultPrim(procMesh.GetPrim());
+    return newLayer;
+}
+
+// Read the instances of a merged layout from the proctest file, one per
+// line as either "sideLength tx ty tz" or "sideLength" followed by the 16
+// values of a row-major transform matrix. Empty lines and lines starting
+// with '#' are ignored. Malformed lines, and instances whose side length is
+// not positive or whose transform is not finite, are skipped with a
+// warning.
+static bool
+_ReadInstances(const std::string& resolvedPath,
+               std::vector<UsdProctestCubeInstance>* instances)
+{
+    std::ifstream in(resolvedPath);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line = TfStringTrim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream lineStream(line);
+        std::vector<double> values;
+        double value;
+        while (lineStream >> value) {
+            values.push_back(value);
+        }
+
+        UsdProctestCubeInstance instance;
+        if (!lineStream.eof() || (values.size() != 4 && values.size() != 17)) {
+            TF_WARN("%s:%zu: expected 4 or 17 numbers, skipping instance",
+                    resolvedPath.c_str(), lineNumber);
+            continue;
+        }
+        instance.sideLength = static_cast<float>(values[0]);
+        if (!std::isfinite(instance.sideLength) || instance.sideLength <= 0.0f) {
+            TF_WARN("%s:%zu: side length %g is not a positive finite number, "
+                    "skipping instance", resolvedPath.c_str(), lineNumber, values[0]);
+            continue;
+        }
+        if (!std::all_of(values.begin() + 1, values.end(),
+                         [](double v) { return std::isfinite(v); })) {
+            TF_WARN("%s:%zu: transform is not finite, skipping instance",
+                    resolvedPath.c_str(), lineNumber);
+            continue;
+        }
+        if (values.size() == 4) {
+            instance.transform.SetTranslate(GfVec3d(values[1], values[2], values[3]));
+        } else {
+            instance.transform.Set(
+                values[1], values[2], values[3], values[4],
+                values[5], values[6], values[7], values[8],
+                values[9], values[10], values[11], values[12],
+                values[13], values[14], values[15], values[16]);
+        }
+        instances->push_back(instance);
+    }
+    return true;
+}
+
+// Implicit default value of a generated attribute, registered on the
+// proctest data once the content is copied to it.
+struct _ImplicitDefault {
+    SdfPath specPath;
+    UsdProctestData::ValueFn fn;
+    size_t heldBytes = 0;
+    bool cacheable = true;
+};
+using _ImplicitDefaults = std::vector<_ImplicitDefault>;
+
+struct _CubeGeometryOptions {
+    TfToken pointsPrecision;
+    bool sideSubsets = false;
+    // Leave the points implicit, generating them only if they are read.
+    bool deferPoints = false;
+};
+
+// Author the geometry of the cube, or of the merged instances when there
+// are any, on mesh at the current edit target of its stage. Content derived
+// from the cube parameters is left implicit.
+static void
+_DefineCubeGeometry(const UsdGeomMesh& mesh,
+                    const UsdProctestCubeParams& params,
+                    const std::shared_ptr<const std::vector<UsdProctestCubeInstance>>& instances,
+                    const _CubeGeometryOptions& options,
+                    const std::string& layerIdentifier,
+                    _ImplicitDefaults* implicitDefaults)
+{
+    const UsdEditTarget editTarget = mesh.GetPrim().GetStage()->GetEditTarget();
+    const bool isMerged = !instances->empty();
+    const size_t instanceCount = isMerged ? instances->size() : 1;
+
+    const auto setImplicitDefault = [&](const UsdAttribute& attr, UsdProctestData::ValueFn fn,
+                                        size_t heldBytes = 0, bool cacheable = true) {
+        implicitDefaults->push_back(
+            {editTarget.MapToSpecPath(attr.GetPath()), std::move(fn), heldBytes, cacheable});
+    };
+    const auto generatePoints = [params, instances]() {
+        return instances->empty() ? UsdProctestGenerateCubePoints(params)
+                                  : UsdProctestGenerateMergedCubePoints(params, *instances);
+    };
+
+    // faceVertexCounts, implicit
+
+    if (UsdAttribute attr = mesh.CreateFaceVertexCountsAttr()) {
+        setImplicitDefault(attr, [params, instanceCount]() {
+            return VtValue::Take(UsdProctestGenerateMergedCubeFaceVertexCounts(params, instanceCount));
+        });
+    } else {
+        TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "faceVertexCounts");
+    }
+
+    // faceVertexIndices, implicit
+
+    if (UsdAttribute attr = mesh.CreateFaceVertexIndicesAttr()) {
+        setImplicitDefault(attr, [params, instanceCount]() {
+            return VtValue::Take(UsdProctestGenerateMergedCubeFaceVertexIndices(params, instanceCount));
+        });
+    } else {
+        TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "faceVertexIndices");
+    }
+
+    // points, implicit when deferred or stored at a reduced precision, in
+    // which case they are kept encoded and decoded on read.
+
+    if (options.deferPoints) {
+        if (UsdAttribute attr = mesh.CreatePointsAttr()) {
+            setImplicitDefault(attr, [generatePoints]() {
+                return VtValue::Take(generatePoints());
+            });
+        } else {
+            TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "points");
+        }
+    } else if (options.pointsPrecision != UsdProctestPointsPrecisionTokens->Float) {
+        const UsdProctestCompactPoints compactPoints =
+            UsdProctestCompactPoints::Encode(generatePoints(), options.pointsPrecision);
+        TF_DEBUG(PROCTEST_INFO).Msg(
+            "%s: %s points use %zu bytes instead of %zu, max error %g\n",
+            layerIdentifier.c_str(), options.pointsPrecision.GetText(),
+            compactPoints.GetSizeInBytes(), compactPoints.GetFullPrecisionSizeInBytes(),
+            compactPoints.GetMaxError());
+        if (!compactPoints.IsEncoded()) {
+            if (!mesh.CreatePointsAttr(VtValue(compactPoints.Decode()))) {
+                TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "points");
+            }
+        } else if (UsdAttribute attr = mesh.CreatePointsAttr()) {
+            // Not cached, as caching the decoded points would keep the full
+            // precision array resident and cancel the saving.
+            setImplicitDefault(attr, [compactPoints]() {
+                return VtValue::Take(compactPoints.Decode());
+            }, compactPoints.GetSizeInBytes(), /* cacheable = */ false);
+        } else {
+            TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "points");
+        }
+    } else if (!mesh.CreatePointsAttr(VtValue::Take(generatePoints()))) {
+        TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "points");
+    }
+
+    // velocities, implicit and only for animated single cubes
+
+    if (!isMerged && params.sideLengthRate != 0.0f) {
+        if (UsdAttribute attr = mesh.CreateVelocitiesAttr()) {
+            setImplicitDefault(attr, [params]() {
+                return VtValue::Take(UsdProctestGenerateCubeVelocities(params));
+            });
+        } else {
+            TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "velocities");
+        }
+    }
+
+    // primvars:instanceId, implicit and only for merged layouts
+
+    if (isMerged) {
+        UsdAttribute attr = UsdGeomPrimvarsAPI(mesh.GetPrim()).CreatePrimvar(
+            UsdProctestFileFormatTokens->InstanceId, SdfValueTypeNames->IntArray,
+            UsdGeomTokens->uniform).GetAttr();
+        if (attr) {
+            setImplicitDefault(attr, [params, instanceCount]() {
+                return VtValue::Take(UsdProctestGenerateMergedCubeInstanceIds(params, instanceCount));
+            });
+        } else {
+            TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "primvars:instanceId");
+        }
+    }
+
+    // Side subsets, implicit and computed from the cube parameters so that
+    // cubes sharing a topology share the same description.
+
+    if (options.sideSubsets) {
+        for (size_t side = 0; side < UsdProctestCubeSideCount; ++side) {
+            UsdGeomSubset subset = UsdGeomSubset::CreateGeomSubset(
+                mesh, TfToken(UsdProctestGetCubeSideName(side)), UsdGeomTokens->face,
+                VtIntArray(), UsdProctestFileFormatTokens->MaterialBind,
+                UsdGeomTokens->partition);
+            if (!subset) {
+                TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "indices");
+                continue;
+            }
+            setImplicitDefault(subset.GetIndicesAttr(), [params, side, instanceCount]() {
+                return VtValue::Take(
+                    UsdProctestGenerateMergedCubeSideFaceIndices(params, side, instanceCount));
+            });
+        }
+    }
 }
 
 UsdProctestFileFormat::UsdProctestFileFormat()
     : SdfFileFormat(UsdProctestFileFormatTokens->Id, UsdProctestFileFormatTokens->Version,
                     UsdProctestFileFormatTokens->Target,
-                    UsdProctestFileFormatTokens->Extension) {}
+                    UsdProctestFileFormatTokens->Extension) {
+  // File formats are created once, when first used.
+  const int interval = TfGetEnvSetting(PROCTEST_REPORT_INTERVAL);
+  if (interval && !_reporter) {
+    std::atexit(_StopReporter);
+    _reporter = new UsdProctestGeneratedBytesReporter(interval);
+  }
+}
 
 UsdProctestFileFormat::~UsdProctestFileFormat() {}
 
@@ -109,47 +538,152 @@ bool UsdProctestFileFormat::Read(SdfLayer *layer, const std::string &resolvedPat
   FileFormatArguments args;
   std::string layerPath;
   SdfLayer::SplitIdentifier(layer->GetIdentifier(), &layerPath, &args);
-  const auto sideLength = _ExtractSideLengthFromArgs(args);
+  const UsdProctestCubeParams params = _ExtractCubeParamsFromArgs(args);
+
+  // Skip regeneration when force reloading unchanged content, which leaves
+  // the layer data untouched. Sdf still sends its reload notice afterwards.
+
+  const uint64_t fingerprint = _ComputeFingerprint(args, params, resolvedPath);
+  UsdProctestDataConstPtr currentData =
+      TfDynamic_cast<UsdProctestDataConstPtr>(_GetLayerData(*layer));
+  if (currentData && currentData->GetFingerprint() == fingerprint && !layer->IsDirty()) {
+    TF_DEBUG(PROCTEST_INFO).Msg("%s: unchanged, skipping regeneration\n",
+                                layer->GetIdentifier().c_str());
+    return true;
+  }
 
-  SdfLayerRefPtr newLayer = SdfLayer::CreateAnonymous(".usd");
-  UsdStageRefPtr stage = UsdStage::Open(newLayer);
+  // Level of detail
 
-  // Define the loaded prim
+  int lodCount = _ExtractValueFromArgs(
+      args, UsdProctestFileFormatTokens->LodCount, defaultLodCountValue);
+  if (lodCount < 1) {
+    TF_WARN("'%s' value %d is less than 1, clamping",
+            UsdProctestFileFormatTokens->LodCount.GetText(), lodCount);
+    lodCount = 1;
+  }
+  const int distinctLodCount = UsdProctestGetCubeLodCount(params);
+  if (lodCount > distinctLodCount) {
+    TF_WARN("'%s' value %d is more than the %d distinct levels of %d divisions, clamping",
+            UsdProctestFileFormatTokens->LodCount.GetText(), lodCount, distinctLodCount,
+            params.divisions);
+    lodCount = distinctLodCount;
+  }
+  int lod = _ExtractValueFromArgs(args, UsdProctestFileFormatTokens->Lod, defaultLodValue);
+  if (lod < 0 || lod >= lodCount) {
+    TF_WARN("'%s' value %d is out of range [0, %d], clamping",
+            UsdProctestFileFormatTokens->Lod.GetText(), lod, lodCount - 1);
+    lod = std::max(0, std::min(lod, lodCount - 1));
+  }
 
-  UsdGeomMesh mesh = UsdGeomMesh::Define(stage, SdfPath("/Root"));
-  stage->SetDefaultPrim(mesh.GetPrim());
+  // Points precision
+
+  TfToken pointsPrecision(_ExtractValueFromArgs(
+      args, UsdProctestFileFormatTokens->PointsPrecision,
+      UsdProctestPointsPrecisionTokens->Float.GetString()));
+  if (pointsPrecision != UsdProctestPointsPrecisionTokens->Float &&
+      pointsPrecision != UsdProctestPointsPrecisionTokens->Half &&
+      pointsPrecision != UsdProctestPointsPrecisionTokens->Quantized) {
+    TF_WARN("Unknown '%s' value '%s', using '%s'",
+            UsdProctestFileFormatTokens->PointsPrecision.GetText(),
+            pointsPrecision.GetText(),
+            UsdProctestPointsPrecisionTokens->Float.GetText());
+    pointsPrecision = UsdProctestPointsPrecisionTokens->Float;
+  }
 
-  // faceVertexCounts
+  // Merge mode, when the proctest file lists instances
 
-  VtIntArray faceVertexCounts(6, 4);
-  if (!mesh.CreateFaceVertexCountsAttr(VtValue(faceVertexCounts))) {
-    TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "faceVertexCounts");
+  std::vector<UsdProctestCubeInstance> instances;
+  if (!_ReadInstances(resolvedPath, &instances)) {
+    TF_ERROR(PROCTEST_CANNOT_READ_PROCTEST_FILE, "%s", resolvedPath.c_str());
+    return false;
+  }
+  const size_t instanceCount = instances.empty() ? 1 : instances.size();
+  if (!UsdProctestCanMergeCubes(params, instanceCount)) {
+    TF_ERROR(PROCTEST_CANNOT_READ_PROCTEST_FILE,
+             "%s: too many instances to merge (%zu)", resolvedPath.c_str(), instanceCount);
+    return false;
   }
 
-  // faceVertexIndices
+  // Bake mode, of the selected level of detail of single cubes only
 
-  VtIntArray faceVertexIndices = {0, 4, 6, 2, 3, 2, 6, 7, 7, 6, 4, 5, 5, 1, 3, 7, 1, 0, 2, 3, 5, 4, 0, 1};
-  if (!mesh.CreateFaceVertexIndicesAttr(VtValue(faceVertexIndices))) {
-    TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "faceVertexIndices");
+  std::string bakePath = _ExtractValueFromArgs(
+      args, UsdProctestFileFormatTokens->BakePath, std::string());
+  if (!bakePath.empty()) {
+    if (!instances.empty()) {
+      TF_ERROR(PROCTEST_CANNOT_BAKE, "%s: '%s' is set but merged layouts cannot be baked",
+               resolvedPath.c_str(), UsdProctestFileFormatTokens->BakePath.GetText());
+      return false;
+    }
+    // Bakes hold the points as floats, without velocities nor subsets.
+    if (params.sideLengthRate != defaultSideLengthRateValue) {
+      TF_WARN("%s: '%s' is ignored when '%s' is set, bakes have no velocities",
+              resolvedPath.c_str(), UsdProctestFileFormatTokens->SideLengthRate.GetText(),
+              UsdProctestFileFormatTokens->BakePath.GetText());
+    }
+    if (pointsPrecision != UsdProctestPointsPrecisionTokens->Float) {
+      TF_WARN("%s: '%s' is ignored when '%s' is set, bakes hold float points",
+              resolvedPath.c_str(), UsdProctestFileFormatTokens->PointsPrecision.GetText(),
+              UsdProctestFileFormatTokens->BakePath.GetText());
+    }
+    if (_ExtractValueFromArgs(args, UsdProctestFileFormatTokens->SideSubsets,
+                              defaultSideSubsetsValue)) {
+      TF_WARN("%s: '%s' is ignored when '%s' is set, bakes have no subsets",
+              resolvedPath.c_str(), UsdProctestFileFormatTokens->SideSubsets.GetText(),
+              UsdProctestFileFormatTokens->BakePath.GetText());
+    }
+    if (TfIsRelativePath(bakePath)) {
+      bakePath = TfStringCatPaths(TfGetPathName(resolvedPath), bakePath);
+    }
+    SdfLayerRefPtr bakedLayer =
+        _GenerateBakedLayer(UsdProctestGetCubeLodParams(params, lod), bakePath);
+    if (!bakedLayer) {
+      return false;
+    }
+    _SetContentHash(bakedLayer, UsdProctestHashBakeFiles(
+        bakePath, _ComputeContentHash(args, params, instances,
+                                      UsdSchemaRegistry::GetSchemaTypeName<UsdProcTestMyProcMesh>())));
+    UsdProctestDataRefPtr data = UsdProctestData::New();
+    data->CopyFrom(_GetLayerData(*bakedLayer));
+    data->SetFingerprint(fingerprint);
+    data->SetLayerIdentifier(layer->GetIdentifier());
+    SdfAbstractDataRefPtr layerData = data;
+    _SetLayerData(layer, layerData);
+    return true;
   }
 
-  // points
-
-  const float halfLength = sideLength / 2.0f;
-
-  VtVec3fArray points = {
-    {halfLength, halfLength, halfLength},
-    {halfLength, halfLength, -halfLength},
-    {halfLength, -halfLength, halfLength},
-    {halfLength, -halfLength, -halfLength},
-    {-halfLength, halfLength, halfLength},
-    {-halfLength, halfLength, -halfLength},
-    {-halfLength, -halfLength, halfLength},
-    {-halfLength, -halfLength, -halfLength}
-  };
-  if (!mesh.CreatePointsAttr(VtValue(points))) {
-    TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "points");
+  // A single cube is a MyProcMesh whose schema attributes hold the
+  // parameters. Merged layouts and levels of detail, whose geometry these
+  // attributes do not describe, are plain meshes.
+
+  const bool isProcMesh = instances.empty() && lodCount == 1;
+  const TfToken primTypeName = isProcMesh
+      ? UsdSchemaRegistry::GetSchemaTypeName<UsdProcTestMyProcMesh>()
+      : UsdSchemaRegistry::GetSchemaTypeName<UsdGeomMesh>();
+  const uint64_t contentHash = _ComputeContentHash(args, params, instances, primTypeName);
+  const auto sharedInstances =
+      std::make_shared<const std::vector<UsdProctestCubeInstance>>(std::move(instances));
+
+  SdfLayerRefPtr newLayer = SdfLayer::CreateAnonymous(".usd");
+  _SetContentHash(newLayer, contentHash);
+  UsdStageRefPtr stage = UsdStage::Open(newLayer);
+
+  // Define the loaded prim
+
+  const SdfPath rootPath("/Root");
+  UsdGeomMesh mesh;
+  if (isProcMesh) {
+    const UsdProcTestMyProcMesh procMesh = UsdProcTestMyProcMesh::Define(stage, rootPath);
+    if (!procMesh.CreateLengthAttr(VtValue(params.sideLength))) {
+      TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "length");
+    }
+    if (!procMesh.CreateDivisionsAttr(VtValue(params.divisions))) {
+      TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "divisions");
+    }
+    mesh = procMesh;
+  } else {
+    mesh = UsdGeomMesh::Define(stage, rootPath);
   }
+  stage->SetDefaultPrim(mesh.GetPrim());
 
   // subdivisionScheme
 
@@ -157,9 +691,64 @@ bool UsdProctestFileFormat::Read(SdfLayer *layer, const std::string &resolvedPat
     TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "subdivisionScheme");
   }
 
-  // transfer the layer
+  // Spatial index over the instances of merged layouts, see
+  // UsdProctestBvh::Read.
+
+  if (!sharedInstances->empty() &&
+      !UsdProctestBvh::Build(UsdProctestComputeMergedCubeBounds(*sharedInstances))
+           .Write(mesh.GetPrim())) {
+    TF_ERROR(PROCTEST_CANNOT_CREATE_ATTRIBUTE, "proctest:bvh");
+  }
 
-  layer->TransferContent(newLayer);
+  // Geometry, in a variant per level of detail when there are several. The
+  // points of the level selected by the arguments are generated now, those
+  // of the other levels only if read through another variant selection.
+
+  _CubeGeometryOptions options;
+  options.pointsPrecision = pointsPrecision;
+  options.sideSubsets = _ExtractValueFromArgs(args, UsdProctestFileFormatTokens->SideSubsets,
+                                              defaultSideSubsetsValue);
+
+  _ImplicitDefaults implicitDefaults;
+  if (lodCount == 1) {
+    _DefineCubeGeometry(mesh, params, sharedInstances, options, layer->GetIdentifier(),
+                        &implicitDefaults);
+  } else {
+    UsdVariantSet lodVariantSet = mesh.GetPrim().GetVariantSets().AddVariantSet(
+        UsdProctestFileFormatTokens->LodVariantSet);
+    for (int level = 0; level < lodCount; ++level) {
+      const std::string variant = _GetLodVariantName(level);
+      lodVariantSet.AddVariant(variant);
+      lodVariantSet.SetVariantSelection(variant);
+
+      UsdEditContext editContext(lodVariantSet.GetVariantEditContext());
+      options.deferPoints = level != lod;
+      _DefineCubeGeometry(mesh, UsdProctestGetCubeLodParams(params, level), sharedInstances,
+                          options, layer->GetIdentifier(), &implicitDefaults);
+    }
+    lodVariantSet.SetVariantSelection(_GetLodVariantName(lod));
+  }
+
+  // Move the content to proctest data, where the topology is held by the
+  // cube parameters and regenerated on read. It is a regular grid pattern
+  // that is much cheaper to expand than to keep resident.
+
+  UsdProctestDataRefPtr data = UsdProctestData::New();
+  data->CopyFrom(_GetLayerData(*newLayer));
+  data->SetFingerprint(fingerprint);
+  data->SetLayerIdentifier(layer->GetIdentifier());
+  for (auto& implicitDefault : implicitDefaults) {
+    data->SetImplicitDefault(implicitDefault.specPath, std::move(implicitDefault.fn),
+                             implicitDefault.heldBytes, implicitDefault.cacheable);
+  }
+
+  SdfAbstractDataRefPtr layerData = data;
+  _SetLayerData(layer, layerData);
+
+  TF_DEBUG(PROCTEST_INFO).Msg("%s: %zu generated bytes, %zu for all proctest layers\n",
+                              layer->GetIdentifier().c_str(),
+                              data->GetResidentBytes().GetTotal(),
+                              UsdProctestData::GetGlobalResidentBytes().GetTotal());
   return true;
 }
 
@@ -181,8 +770,51 @@ void UsdProctestFileFormat::ComposeFieldsForFileFormatArguments(
   FileFormatArguments* args,
   VtValue* contextDependencyData) const
 {
-    auto sideLength = _ExtractSideLengthFromContext(context);
+    auto sideLength = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->SideLength, defaultSideLengthValue);
     (*args)[UsdProctestFileFormatTokens->SideLength] = TfStringify(sideLength);
+
+    auto sideLengthRate = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->SideLengthRate, defaultSideLengthRateValue);
+    if (sideLengthRate != defaultSideLengthRateValue) {
+        (*args)[UsdProctestFileFormatTokens->SideLengthRate] = TfStringify(sideLengthRate);
+    }
+
+    auto divisions = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->Divisions, defaultDivisionsValue);
+    if (divisions != defaultDivisionsValue) {
+        (*args)[UsdProctestFileFormatTokens->Divisions] = TfStringify(divisions);
+    }
+
+    auto sideSubsets = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->SideSubsets, defaultSideSubsetsValue);
+    if (sideSubsets != defaultSideSubsetsValue) {
+        (*args)[UsdProctestFileFormatTokens->SideSubsets] = TfStringify(sideSubsets);
+    }
+
+    auto lodCount = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->LodCount, defaultLodCountValue);
+    if (lodCount != defaultLodCountValue) {
+        (*args)[UsdProctestFileFormatTokens->LodCount] = TfStringify(lodCount);
+    }
+
+    auto lod = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->Lod, defaultLodValue);
+    if (lod != defaultLodValue) {
+        (*args)[UsdProctestFileFormatTokens->Lod] = TfStringify(lod);
+    }
+
+    auto pointsPrecision = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->PointsPrecision, std::string());
+    if (!pointsPrecision.empty()) {
+        (*args)[UsdProctestFileFormatTokens->PointsPrecision] = pointsPrecision;
+    }
+
+    auto bakePath = _ExtractValueFromContext(
+        context, UsdProctestFileFormatTokens->BakePath, std::string());
+    if (!bakePath.empty()) {
+        (*args)[UsdProctestFileFormatTokens->BakePath] = bakePath;
+    }
 }
 
 bool UsdProctestFileFormat::CanFieldChangeAffectFileFormatArguments(
@@ -191,15 +823,33 @@ bool UsdProctestFileFormat::CanFieldChangeAffectFileFormatArguments(
   const VtValue& newValue,
   const VtValue& contextDependencyData) const
 {
+    if (field == UsdProctestFileFormatTokens->SideLengthRate) {
+        return _HasValueChanged(oldValue, newValue, defaultSideLengthRateValue);
+    }
+
+    if (field == UsdProctestFileFormatTokens->Divisions) {
+        return _HasValueChanged(oldValue, newValue, defaultDivisionsValue);
+    }
+
+    if (field == UsdProctestFileFormatTokens->SideSubsets) {
+        return _HasValueChanged(oldValue, newValue, defaultSideSubsetsValue);
+    }
+
+    if (field == UsdProctestFileFormatTokens->LodCount) {
+        return _HasValueChanged(oldValue, newValue, defaultLodCountValue);
+    }
+
+    if (field == UsdProctestFileFormatTokens->Lod) {
+        return _HasValueChanged(oldValue, newValue, defaultLodValue);
+    }
+
+    if (field == UsdProctestFileFormatTokens->PointsPrecision ||
+        field == UsdProctestFileFormatTokens->BakePath) {
+        return _HasValueChanged(oldValue, newValue, std::string());
+    }
+
     // Check if the "sideLength" argument changed.
-    auto oldLength = oldValue.IsHolding<float>()
-                           ? oldValue.UncheckedGet<float>()
-                           : defaultSideLengthValue;
-    auto newLength = newValue.IsHolding<float>()
-                           ? newValue.UncheckedGet<float>()
-                           : defaultSideLengthValue;
-
-    return oldLength != newLength;
+    return _HasValueChanged(oldValue, newValue, defaultSideLengthValue);
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
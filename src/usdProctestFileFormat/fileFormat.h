@@ -18,7 +18,18 @@ PXR_NAMESPACE_OPEN_SCOPE
     ((Version, "1.0"))                              \
     ((Target, "usd"))                               \
     ((Extension, "proctest"))                       \
-    ((SideLength, "Usd_Proctest_SideLength"))
+    ((SideLength, "Usd_Proctest_SideLength"))       \
+    ((Divisions, "Usd_Proctest_Divisions"))         \
+    ((SideLengthRate, "Usd_Proctest_SideLengthRate")) \
+    ((BakePath, "Usd_Proctest_BakePath"))           \
+    ((SideSubsets, "Usd_Proctest_SideSubsets"))     \
+    ((PointsPrecision, "Usd_Proctest_PointsPrecision")) \
+    ((LodCount, "Usd_Proctest_LodCount"))           \
+    ((Lod, "Usd_Proctest_Lod"))                     \
+    ((LodVariantSet, "lod"))                        \
+    ((MaterialBind, "materialBind"))                \
+    ((InstanceId, "instanceId"))                    \
+    ((ContentHash, "proctest:contentHash"))
 /* clang-format on */
 
 TF_DECLARE_PUBLIC_TOKENS(UsdProctestFileFormatTokens, USD_PROCTEST_FILE_FORMAT_TOKENS);